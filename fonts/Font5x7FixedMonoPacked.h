@@ -0,0 +1,144 @@
+/**
+ * Font5x7FixedMonoPacked, generated from Font5x7FixedMono.h by tools/fontconv.c
+ */
+
+#pragma once
+#include "ssd1309_font.h"
+
+const uint8_t Font5x7FixedMonoPackedData[] = {
+    0x5F, 0x03, 0x00, 0x03, 0x14, 0x7F, 0x14, 0x7F, 0x14, 0x24, 0x2A, 0x7F,
+    0x2A, 0x12, 0x23, 0x13, 0x08, 0x64, 0x62, 0x36, 0x49, 0x55, 0x22, 0x50,
+    0x05, 0x03, 0x3E, 0x41, 0x41, 0x3E, 0x2A, 0x1C, 0x7F, 0x1C, 0x2A, 0x04,
+    0x04, 0x1F, 0x04, 0x04, 0x01, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x03,
+    0x03, 0x10, 0x08, 0x04, 0x02, 0x01, 0x3E, 0x51, 0x49, 0x45, 0x3E, 0x42,
+    0x7F, 0x40, 0x42, 0x61, 0x51, 0x49, 0x46, 0x21, 0x41, 0x45, 0x4B, 0x31,
+    0x18, 0x14, 0x12, 0x7F, 0x10, 0x2F, 0x49, 0x49, 0x49, 0x31, 0x3C, 0x4A,
+    0x49, 0x49, 0x30, 0x01, 0x71, 0x09, 0x05, 0x03, 0x36, 0x49, 0x49, 0x49,
+    0x36, 0x06, 0x49, 0x49, 0x29, 0x1E, 0x1B, 0x1B, 0x2B, 0x1B, 0x08, 0x14,
+    0x22, 0x41, 0x05, 0x05, 0x05, 0x05, 0x05, 0x41, 0x22, 0x14, 0x08, 0x02,
+    0x01, 0x51, 0x09, 0x06, 0x3E, 0x41, 0x5D, 0x59, 0x1E, 0x7C, 0x0A, 0x09,
+    0x0A, 0x7C, 0x7F, 0x49, 0x49, 0x49, 0x36, 0x3E, 0x41, 0x41, 0x41, 0x22,
+    0x7F, 0x41, 0x41, 0x22, 0x1C, 0x7F, 0x49, 0x49, 0x49, 0x41, 0x7F, 0x09,
+    0x09, 0x09, 0x01, 0x3E, 0x41, 0x41, 0x49, 0x3A, 0x7F, 0x08, 0x08, 0x08,
+    0x7F, 0x41, 0x7F, 0x41, 0x20, 0x40, 0x41, 0x3F, 0x01, 0x00, 0x7F, 0x08,
+    0x14, 0x22, 0x41, 0x7F, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x02, 0x04, 0x02,
+    0x7F, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x3E, 0x41, 0x41, 0x41, 0x3E, 0x7F,
+    0x09, 0x09, 0x09, 0x06, 0x3E, 0x41, 0x51, 0x21, 0x5E, 0x7F, 0x09, 0x19,
+    0x29, 0x46, 0x46, 0x49, 0x49, 0x49, 0x31, 0x01, 0x01, 0x7F, 0x01, 0x01,
+    0x3F, 0x40, 0x40, 0x40, 0x3F, 0x1F, 0x20, 0x40, 0x20, 0x1F, 0x7F, 0x20,
+    0x10, 0x20, 0x7F, 0x63, 0x14, 0x08, 0x14, 0x63, 0x03, 0x04, 0x78, 0x04,
+    0x03, 0x61, 0x51, 0x49, 0x45, 0x43, 0x7F, 0x41, 0x41, 0x01, 0x02, 0x04,
+    0x08, 0x10, 0x41, 0x41, 0x7F, 0x04, 0x02, 0x01, 0x02, 0x04, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x02, 0x04, 0x08, 0x15, 0x15, 0x15, 0x1E, 0x7F,
+    0x44, 0x44, 0x44, 0x38, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x38, 0x44, 0x44,
+    0x44, 0x7F, 0x0E, 0x15, 0x15, 0x15, 0x06, 0x08, 0x7E, 0x09, 0x02, 0x02,
+    0x15, 0x15, 0x15, 0x0F, 0x7F, 0x04, 0x04, 0x04, 0x78, 0x7D, 0x20, 0x40,
+    0x40, 0x3D, 0x7F, 0x10, 0x28, 0x44, 0x7F, 0x1F, 0x01, 0x06, 0x01, 0x1F,
+    0x1F, 0x02, 0x01, 0x01, 0x1E, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x1F, 0x05,
+    0x05, 0x05, 0x02, 0x02, 0x05, 0x05, 0x05, 0x1F, 0x1F, 0x02, 0x01, 0x01,
+    0x02, 0x12, 0x15, 0x15, 0x15, 0x09, 0x04, 0x04, 0x3F, 0x44, 0x24, 0x0F,
+    0x10, 0x10, 0x10, 0x0F, 0x07, 0x08, 0x10, 0x08, 0x07, 0x0F, 0x10, 0x0C,
+    0x10, 0x0F, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x03, 0x14, 0x14, 0x14, 0x0F,
+    0x11, 0x19, 0x15, 0x13, 0x11, 0x08, 0x36, 0x41, 0x7F, 0x45, 0x30, 0x09,
+    0x03, 0x01, 0x03, 0x02, 0x03,
+};
+
+const ssd1309_glyph_t Font5x7FixedMonoPackedGlyphs[] = {
+    {0, 0, 1, 6, 0, 0}, // 0x20 ' '
+    {0, 1, 7, 6, 2, -7}, // 0x21 '!'
+    {1, 3, 2, 6, 1, -7}, // 0x22 '"'
+    {4, 5, 7, 6, 0, -7}, // 0x23 '#'
+    {9, 5, 7, 6, 0, -7}, // 0x24 '$'
+    {14, 5, 7, 6, 0, -7}, // 0x25 '%'
+    {19, 5, 7, 6, 0, -7}, // 0x26 '&'
+    {24, 2, 3, 6, 1, -7}, // 0x27 '''
+    {26, 2, 7, 6, 2, -7}, // 0x28 '('
+    {28, 2, 7, 6, 1, -7}, // 0x29 ')'
+    {30, 5, 7, 6, 0, -7}, // 0x2A '*'
+    {35, 5, 5, 6, 0, -6}, // 0x2B '+'
+    {40, 2, 2, 6, 1, -2}, // 0x2C ','
+    {42, 5, 1, 6, 0, -4}, // 0x2D '-'
+    {47, 2, 2, 6, 1, -2}, // 0x2E '.'
+    {49, 5, 5, 6, 0, -6}, // 0x2F '/'
+    {54, 5, 7, 6, 0, -7}, // 0x30 '0'
+    {59, 3, 7, 6, 1, -7}, // 0x31 '1'
+    {62, 5, 7, 6, 0, -7}, // 0x32 '2'
+    {67, 5, 7, 6, 0, -7}, // 0x33 '3'
+    {72, 5, 7, 6, 0, -7}, // 0x34 '4'
+    {77, 5, 7, 6, 0, -7}, // 0x35 '5'
+    {82, 5, 7, 6, 0, -7}, // 0x36 '6'
+    {87, 5, 7, 6, 0, -7}, // 0x37 '7'
+    {92, 5, 7, 6, 0, -7}, // 0x38 '8'
+    {97, 5, 7, 6, 0, -7}, // 0x39 '9'
+    {102, 2, 5, 6, 1, -6}, // 0x3A ':'
+    {104, 2, 6, 6, 1, -6}, // 0x3B ';'
+    {106, 4, 7, 6, 0, -7}, // 0x3C '<'
+    {110, 5, 3, 6, 0, -5}, // 0x3D '='
+    {115, 4, 7, 6, 1, -7}, // 0x3E '>'
+    {119, 5, 7, 6, 0, -7}, // 0x3F '?'
+    {124, 5, 7, 6, 0, -7}, // 0x40 '@'
+    {129, 5, 7, 6, 0, -7}, // 0x41 'A'
+    {134, 5, 7, 6, 0, -7}, // 0x42 'B'
+    {139, 5, 7, 6, 0, -7}, // 0x43 'C'
+    {144, 5, 7, 6, 0, -7}, // 0x44 'D'
+    {149, 5, 7, 6, 0, -7}, // 0x45 'E'
+    {154, 5, 7, 6, 0, -7}, // 0x46 'F'
+    {159, 5, 7, 6, 0, -7}, // 0x47 'G'
+    {164, 5, 7, 6, 0, -7}, // 0x48 'H'
+    {169, 3, 7, 6, 1, -7}, // 0x49 'I'
+    {172, 6, 7, 6, 0, -7}, // 0x4A 'J'
+    {178, 5, 7, 6, 0, -7}, // 0x4B 'K'
+    {183, 5, 7, 6, 0, -7}, // 0x4C 'L'
+    {188, 5, 7, 6, 0, -7}, // 0x4D 'M'
+    {193, 5, 7, 6, 0, -7}, // 0x4E 'N'
+    {198, 5, 7, 6, 0, -7}, // 0x4F 'O'
+    {203, 5, 7, 6, 0, -7}, // 0x50 'P'
+    {208, 5, 7, 6, 0, -7}, // 0x51 'Q'
+    {213, 5, 7, 6, 0, -7}, // 0x52 'R'
+    {218, 5, 7, 6, 0, -7}, // 0x53 'S'
+    {223, 5, 7, 6, 0, -7}, // 0x54 'T'
+    {228, 5, 7, 6, 0, -7}, // 0x55 'U'
+    {233, 5, 7, 6, 0, -7}, // 0x56 'V'
+    {238, 5, 7, 6, 0, -7}, // 0x57 'W'
+    {243, 5, 7, 6, 0, -7}, // 0x58 'X'
+    {248, 5, 7, 6, 0, -7}, // 0x59 'Y'
+    {253, 5, 7, 6, 0, -7}, // 0x5A 'Z'
+    {258, 3, 7, 6, 1, -7}, // 0x5B '['
+    {261, 5, 5, 6, 0, -6}, // 0x5C
+    {266, 3, 7, 6, 1, -7}, // 0x5D ']'
+    {269, 5, 3, 6, 0, -7}, // 0x5E '^'
+    {274, 5, 1, 6, 0, -1}, // 0x5F '_'
+    {279, 3, 3, 6, 1, -7}, // 0x60 '`'
+    {282, 5, 5, 6, 0, -5}, // 0x61 'a'
+    {287, 5, 7, 6, 0, -7}, // 0x62 'b'
+    {292, 5, 5, 6, 0, -5}, // 0x63 'c'
+    {297, 5, 7, 6, 0, -7}, // 0x64 'd'
+    {302, 5, 5, 6, 0, -5}, // 0x65 'e'
+    {307, 4, 7, 6, 0, -7}, // 0x66 'f'
+    {311, 5, 5, 6, 0, -5}, // 0x67 'g'
+    {316, 5, 7, 6, 0, -7}, // 0x68 'h'
+    {321, 1, 7, 6, 2, -7}, // 0x69 'i'
+    {322, 4, 7, 6, 0, -7}, // 0x6A 'j'
+    {326, 4, 7, 6, 0, -7}, // 0x6B 'k'
+    {330, 1, 7, 6, 2, -7}, // 0x6C 'l'
+    {331, 5, 5, 6, 0, -5}, // 0x6D 'm'
+    {336, 5, 5, 6, 0, -5}, // 0x6E 'n'
+    {341, 5, 5, 6, 0, -5}, // 0x6F 'o'
+    {346, 5, 5, 6, 0, -5}, // 0x70 'p'
+    {351, 5, 5, 6, 0, -5}, // 0x71 'q'
+    {356, 5, 5, 6, 0, -5}, // 0x72 'r'
+    {361, 5, 5, 6, 0, -5}, // 0x73 's'
+    {366, 5, 7, 6, 0, -7}, // 0x74 't'
+    {371, 5, 5, 6, 0, -5}, // 0x75 'u'
+    {376, 5, 5, 6, 0, -5}, // 0x76 'v'
+    {381, 5, 5, 6, 0, -5}, // 0x77 'w'
+    {386, 5, 5, 6, 0, -5}, // 0x78 'x'
+    {391, 5, 5, 6, 0, -5}, // 0x79 'y'
+    {396, 5, 5, 6, 0, -5}, // 0x7A 'z'
+    {401, 3, 7, 6, 1, -7}, // 0x7B '{'
+    {404, 1, 7, 6, 2, -7}, // 0x7C '|'
+    {405, 3, 7, 6, 1, -7}, // 0x7D '}'
+    {408, 5, 2, 6, 0, -4}, // 0x7E '~'
+};
+
+const ssd1309_font_t Font5x7FixedMonoPacked = {Font5x7FixedMonoPackedData, Font5x7FixedMonoPackedGlyphs, 0x20, 0x7E, 8};
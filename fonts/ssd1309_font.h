@@ -0,0 +1,27 @@
+#ifndef _SSD1309_FONT_H
+#define _SSD1309_FONT_H
+
+#include <stdint.h>
+
+/// Glyph of a page-major font, generated by tools/fontconv.c
+typedef struct {
+  uint16_t offset; ///< Offset of the first column into ssd1309_font_t->data
+  uint8_t width;   ///< Number of columns
+  uint8_t height;  ///< Number of rows
+  uint8_t xAdvance; ///< Distance to advance cursor (x axis)
+  int8_t xOffset;  ///< X dist from cursor pos to UL corner
+  int8_t yOffset;  ///< Y dist from cursor pos to UL corner
+} ssd1309_glyph_t;
+
+/// Page-major font: every glyph column is stored as (height + 7) / 8 bytes,
+/// the LSB of the first byte being the top row, the way the SSD1309 GDDRAM
+/// lays out a page.
+typedef struct {
+  const uint8_t *data;           ///< Glyph columns, concatenated
+  const ssd1309_glyph_t *glyph;  ///< Glyph array
+  uint16_t first;                ///< ASCII extents (first char)
+  uint16_t last;                 ///< ASCII extents (last char)
+  uint8_t yAdvance;              ///< Newline distance (y axis)
+} ssd1309_font_t;
+
+#endif
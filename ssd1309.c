@@ -2,8 +2,8 @@
 
 #include <stdarg.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
-#include <stdio.h>
 
 #include "fonts/Font5x7FixedMono.h"
 
@@ -55,6 +55,44 @@
 #define SSD1309_setPreChargePeriod 0xD9			/** set pre-charge period */
 #define SSD1309_setVCOMHdeselectLevel 0xDB		/** set VCOMH deselect level */
 
+#ifndef SSD1309_TRANSACTION_COST
+#define SSD1309_TRANSACTION_COST 8 /** fixed cost of one DC/CS cycle, expressed in data bytes */
+#endif
+#define SSD1309_WINDOW_COMMANDS 6	   /** command bytes needed to set an address window */
+#define SSD1309_WINDOW_TRANSACTIONS 2 /** DC/CS cycles per window (one for commands and one for data) */
+#define SSD1309_WINDOW_COST (SSD1309_WINDOW_COMMANDS + SSD1309_WINDOW_TRANSACTIONS * SSD1309_TRANSACTION_COST)
+
+
+// Panel geometry, folded into constants when the build fixes it (see ssd1309.h).
+// The fixed variants still name p, so functions using only the geometry keep p in use.
+#ifdef SSD1309_FIXED_WIDTH
+#define _SSD1309_WIDTH(p) ((void)(p), (uint8_t)SSD1309_FIXED_WIDTH)
+#else
+#define _SSD1309_WIDTH(p) ((p)->width)
+#endif
+#ifdef SSD1309_FIXED_HEIGHT
+#define _SSD1309_HEIGHT(p) ((void)(p), (uint8_t)SSD1309_FIXED_HEIGHT)
+#define _SSD1309_PAGES(p) ((void)(p), (uint8_t)(SSD1309_FIXED_HEIGHT / 8))
+#else
+#define _SSD1309_HEIGHT(p) ((p)->height)
+#define _SSD1309_PAGES(p) ((p)->pages)
+#endif
+
+// Size of the drawing coordinates, swapped for the transposed orientations
+#define _SSD1309_VIEW_WIDTH(p) ((p)->transposed ? _SSD1309_HEIGHT(p) : _SSD1309_WIDTH(p))
+#define _SSD1309_VIEW_HEIGHT(p) ((p)->transposed ? _SSD1309_WIDTH(p) : _SSD1309_HEIGHT(p))
+
+// Bytes of a page in the buffer, which only holds buffer_page in strip mode
+#define _SSD1309_ROW(p, page) ((p)->buffer + ((page) - (p)->buffer_page) * _SSD1309_WIDTH(p))
+
+#define SSD1309_LINE_RANGE 0x00FFFFFF /** lines are pre-clipped to +-SSD1309_LINE_RANGE */
+
+typedef enum
+{
+    _SSD1309_OP_SET,
+    _SSD1309_OP_CLEAR,
+    _SSD1309_OP_INVERT
+} _ssd1309_op_t;
 
 inline static void _swap(int32_t *a, int32_t *b)
 {
@@ -63,14 +101,26 @@ inline static void _swap(int32_t *a, int32_t *b)
     *b = t;
 }
 
-inline static void _ssd1309_write_command(ssd1309_t *p, uint8_t val)
+inline static void _ssd1309_drain(ssd1309_t *p)
 {
+    while (ssd1309_poll(p))
+        ;
+}
+
+inline static void _ssd1309_write_commands(ssd1309_t *p, uint8_t *cmds, size_t len)
+{
+    _ssd1309_drain(p);
     p->pin_cb(SSD1309_PIN_DC, false);
     p->pin_cb(SSD1309_PIN_CS, false);
-    p->spi_cb(&val, 1);
+    p->spi_cb(cmds, len);
     p->pin_cb(SSD1309_PIN_CS, true);
 }
 
+inline static void _ssd1309_write_command(ssd1309_t *p, uint8_t val)
+{
+    _ssd1309_write_commands(p, &val, 1);
+}
+
 inline static void _ssd1309_write_data(ssd1309_t *p, uint8_t *data, size_t size)
 {
     p->pin_cb(SSD1309_PIN_DC, true);
@@ -79,9 +129,68 @@ inline static void _ssd1309_write_data(ssd1309_t *p, uint8_t *data, size_t size)
     p->pin_cb(SSD1309_PIN_CS, true);
 }
 
+inline static void _ssd1309_damage_add(ssd1309_damage_t *d, uint8_t page, uint8_t x0, uint8_t x1)
+{
+    if (x0 < d->x0[page])
+        d->x0[page] = x0;
+    if (x1 > d->x1[page])
+        d->x1[page] = x1;
+}
+
+inline static void _ssd1309_damage_merge(ssd1309_damage_t *d, const ssd1309_damage_t *src)
+{
+    for (uint8_t page = 0; page < SSD1309_MAX_PAGES; ++page)
+        if (src->x0[page] <= src->x1[page])
+            _ssd1309_damage_add(d, page, src->x0[page], src->x1[page]);
+}
+
+inline static void _ssd1309_damage_clear(ssd1309_damage_t *d)
+{
+    memset(d->x0, 0xFF, sizeof(d->x0));
+    memset(d->x1, 0x00, sizeof(d->x1));
+}
+
+inline static void _ssd1309_mark_dirty(ssd1309_t *p, uint8_t page, uint8_t x0, uint8_t x1)
+{
+    _ssd1309_damage_add(&p->dirty, page, x0, x1);
+}
+
+inline static void _ssd1309_set_window(ssd1309_t *p, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1)
+{
+    uint8_t cmds[SSD1309_WINDOW_COMMANDS] = {
+        SSD1309_setColumnAddress,
+        x0 + p->column_offset, // Column start address (0 = reset)
+        x1 + p->column_offset, // Column end address (127 = reset)
+
+        SSD1309_setPageAddress,
+        page0, // Page start address (0 = reset)
+        page1, // Page end address
+    };
+
+    _ssd1309_write_commands(p, cmds, sizeof(cmds));
+}
+
+static bool _ssd1309_supported(uint16_t width, uint16_t height)
+{
+    if (width == 0 || width > 128 || height == 0 || height > SSD1309_MAX_PAGES * 8)
+        return false;
+#ifdef SSD1309_FIXED_WIDTH
+    if (width != SSD1309_FIXED_WIDTH)
+        return false;
+#endif
+#ifdef SSD1309_FIXED_HEIGHT
+    if (height != SSD1309_FIXED_HEIGHT)
+        return false;
+#endif
+    return true;
+}
+
 /**
  *   @brief initialize ssd1309 display
  *
+ *   The frame buffer is allocated on the heap, see ssd1309_init_with_buffer()
+ *   for a caller-provided one.
+ *
  *   @param[in,out] p : pointer to instance of ssd1309_t
  *   @param[in] width : width of display
  *   @param[in] height : heigth of display
@@ -96,6 +205,32 @@ inline static void _ssd1309_write_data(ssd1309_t *p, uint8_t *data, size_t size)
  *
  */
 bool ssd1309_init(ssd1309_t *p, uint16_t width, uint16_t height, ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb)
+{
+    if (!_ssd1309_supported(width, height))
+        return false;
+
+    const size_t size = SSD1309_BUFFER_SIZE(width, height);
+    uint8_t *buffer = (uint8_t *)malloc(size);
+    if (buffer == NULL)
+    {
+        p->bufsize = 0;
+        return false;
+    }
+
+    if (!ssd1309_init_with_buffer(p, width, height, buffer, size, spi_cb, pin_cb, delay_cb))
+    {
+        free(buffer);
+        return false;
+    }
+
+    p->buffers_owned = 1;
+    return true;
+}
+
+/**
+ *   @brief set up the instance and the controller, buffer holds strips pages or the whole frame if strips is 0
+ */
+static void _ssd1309_init(ssd1309_t *p, uint16_t width, uint16_t height, uint8_t *buffer, uint8_t strips, ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb)
 {
     p->width = width;
     p->height = height;
@@ -105,17 +240,44 @@ bool ssd1309_init(ssd1309_t *p, uint16_t width, uint16_t height, ssd1309_spi_cal
     p->pin_cb = pin_cb;
     p->delay = delay_cb;
 
-    p->bufsize = (p->pages) * (p->width);
-    if ((p->buffer = (uint8_t *)malloc(p->bufsize + 1)) == NULL)
-    {
-        p->bufsize = 0;
-        return false;
-    }
+    p->bufsize = strips != 0 ? p->width : (p->pages) * (p->width);
+    p->buffer = buffer + 1;
+    p->strips = strips;
+    p->buffer_page = strips != 0 ? SSD1309_NO_BUFFER : 0;
+    p->tx_page = 0;
+    _ssd1309_damage_clear(&p->dirty);
+    p->shadow = NULL;
+    p->shadow_owned = false;
+    p->shadow_valid = false;
+
+    p->spi_async_cb = NULL;
+    p->transfer_done = false;
+    p->state = SSD1309_STATE_IDLE;
+    p->window_count = 0;
+
+    p->buffers[0] = p->buffer;
+    p->buffer_count = 1;
+    p->buffers_owned = 0;
+    p->back = 0;
+    p->front = SSD1309_NO_BUFFER;
+    p->queued = SSD1309_NO_BUFFER;
+    _ssd1309_damage_clear(&p->queued_dirty);
 
-    ++(p->buffer);
+    p->glyph_cache = NULL;
+    p->orientation = SSD1309_ROTATE_0;
+    p->transposed = false;
+    p->column_offset = 0;
+    p->start_line = 0;
+    p->scroll = (ssd1309_scroll_t){.area_top = 0, .area_rows = height};
+    ssd1309_reset_clip(p);
+    p->font = &SSD1309_DEFAULT_FONT;
+    p->text_mode = SSD1309_TEXT_TRANSPARENT;
+    p->cell_font = NULL;
 
     // Commands specific to SSD1309
     uint8_t cmds[] = {
+        SSD1309_pwrOff,
+
         SSD1309_setLowCSAinPAM,
         SSD1309_setHighCSAinPAM,
         SSD1309_setMemoryAddressingMode,
@@ -145,18 +307,79 @@ bool ssd1309_init(ssd1309_t *p, uint16_t width, uint16_t height, ssd1309_spi_cal
         SSD1309_default_VCOMHdeselectLevel,
 
         SSD1309_followRAMcontent,
+
+        SSD1309_pwrOn,
     };
 
     ssd1309_reset(p);
-    ssd1309_power(p, false);
-    for (size_t i = 0; i < sizeof(cmds); ++i)
-    {
-        _ssd1309_write_command(p, cmds[i]);
-    }
-    ssd1309_power(p, true);
-    ssd1309_clear(p);
-    ssd1309_show(p);
+    _ssd1309_write_commands(p, cmds, sizeof(cmds));
+    ssd1309_set_orientation(p, SSD1309_ROTATE_0);
+    ssd1309_render(p, NULL, NULL);
+}
+
+/**
+ *   @brief initialize ssd1309 display with a caller-provided frame buffer
+ *
+ *   The buffer needs SSD1309_BUFFER_SIZE(width, height) bytes: one prefix
+ *   byte followed by the frame (p->buffer points behind the prefix). It is
+ *   never freed by the driver, and neither this function nor any other uses
+ *   the heap unless asked to allocate (NULL buffers or caches).
+ *   SSD1309_STATIC_BUFFER() declares a suitable static buffer.
+ *
+ *   @param[in,out] p : pointer to instance of ssd1309_t
+ *   @param[in] width : width of display
+ *   @param[in] height : heigth of display
+ *   @param[in] buffer : frame buffer including the prefix byte
+ *   @param[in] size : size of buffer in bytes
+ *   @param[in] spi_cb : SPI callback
+ *   @param[in] pin_cb : pin callback
+ *   @param[in] delay_cb : delay callback
+ *
+ *   @return bool.
+ *   @retval true for Success
+ *   @retval false if the dimensions are not supported or the buffer is too small
+ *
+ */
+bool ssd1309_init_with_buffer(ssd1309_t *p, uint16_t width, uint16_t height, uint8_t *buffer, size_t size, ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb)
+{
+    if (!_ssd1309_supported(width, height) || buffer == NULL || size < SSD1309_BUFFER_SIZE(width, height))
+        return false;
+
+    _ssd1309_init(p, width, height, buffer, 0, spi_cb, pin_cb, delay_cb);
+    return true;
+}
+
+/**
+ *   @brief initialize ssd1309 display without a frame buffer
+ *
+ *   Instead of a frame, the buffer holds one or two pages (strips) of
+ *   width bytes, an eighth of the RAM at most. The display is then drawn
+ *   with ssd1309_render(), which replays a draw callback once per page;
+ *   drawing outside of the callback has no effect, and ssd1309_show(),
+ *   double buffering and the shadow are not available.
+ *   With two strips and an asynchronous transport, one page is drawn while
+ *   the other is transmitted. The buffer is never freed by the driver.
+ *
+ *   @param[in,out] p : pointer to instance of ssd1309_t
+ *   @param[in] width : width of display
+ *   @param[in] height : heigth of display
+ *   @param[in] buffer : SSD1309_STRIP_BUFFER_SIZE(width, 1) or SSD1309_STRIP_BUFFER_SIZE(width, 2) bytes
+ *   @param[in] size : size of buffer in bytes
+ *   @param[in] spi_cb : SPI callback
+ *   @param[in] pin_cb : pin callback
+ *   @param[in] delay_cb : delay callback
+ *
+ *   @return bool.
+ *   @retval true for Success
+ *   @retval false if the dimensions are not supported or the buffer is too small
+ *
+ */
+bool ssd1309_init_strips(ssd1309_t *p, uint16_t width, uint16_t height, uint8_t *buffer, size_t size, ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb)
+{
+    if (!_ssd1309_supported(width, height) || buffer == NULL || size < SSD1309_STRIP_BUFFER_SIZE(width, 1))
+        return false;
 
+    _ssd1309_init(p, width, height, buffer, size < SSD1309_STRIP_BUFFER_SIZE(width, 2) ? 1 : 2, spi_cb, pin_cb, delay_cb);
     return true;
 }
 
@@ -168,7 +391,11 @@ bool ssd1309_init(ssd1309_t *p, uint16_t width, uint16_t height, ssd1309_spi_cal
  */
 void ssd1309_deinit(ssd1309_t *p)
 {
-    free(p->buffer - 1);
+    ssd1309_set_buffers(p, NULL, 0);
+    ssd1309_shadow_disable(p);
+    ssd1309_glyph_cache_disable(p);
+    if (p->buffers_owned & 1)
+        free(p->buffers[0] - 1);
 }
 
 /**
@@ -185,6 +412,34 @@ void ssd1309_reset(ssd1309_t *p)
     p->delay(10000);
 }
 
+/**
+ * @brief send a sequence of command bytes
+ *
+ * Commands and their arguments are sent with one DC/CS cycle per 32 bytes.
+ * The bytes are copied to the stack first, so cmds may point to constant
+ * data.
+ *
+ * @param[in] p : instance of display
+ * @param[in] cmds : command bytes
+ * @param[in] len : number of command bytes
+ *
+ */
+void ssd1309_write_commands(ssd1309_t *p, const uint8_t *cmds, size_t len)
+{
+    // The SPI callback may use its buffer in place, so the caller's (possibly
+    // constant) bytes are copied before they are sent
+    uint8_t chunk[32];
+
+    while (len > 0)
+    {
+        const size_t n = len < sizeof(chunk) ? len : sizeof(chunk);
+        memcpy(chunk, cmds, n);
+        _ssd1309_write_commands(p, chunk, n);
+        cmds += n;
+        len -= n;
+    }
+}
+
 /**
  *	@brief turn on/off display
  *
@@ -209,8 +464,8 @@ void ssd1309_power(ssd1309_t *p, bool on)
  */
 void ssd1309_contrast(ssd1309_t *p, uint8_t val)
 {
-    _ssd1309_write_command(p, SSD1309_setContrastControl);
-    _ssd1309_write_command(p, val);
+    uint8_t cmds[] = {SSD1309_setContrastControl, val};
+    _ssd1309_write_commands(p, cmds, sizeof(cmds));
 }
 
 /**
@@ -228,403 +483,4495 @@ void ssd1309_invert(ssd1309_t *p, bool inv)
         _ssd1309_write_command(p, SSD1309_inversionOff);
 }
 
+// Segment remap and COM scan direction of each orientation
+static const uint8_t _ssd1309_orientation_cmds[][2] = {
+    [SSD1309_ROTATE_0] = {SSD1309_setSegmentMapFlipped, SSD1309_setCOMoutputFlipped},
+    [SSD1309_ROTATE_180] = {SSD1309_setSegmentMapReset, SSD1309_setCOMoutputNormal},
+    [SSD1309_MIRROR_X] = {SSD1309_setSegmentMapReset, SSD1309_setCOMoutputFlipped},
+    [SSD1309_MIRROR_Y] = {SSD1309_setSegmentMapFlipped, SSD1309_setCOMoutputNormal},
+    [SSD1309_ROTATE_90] = {SSD1309_setSegmentMapReset, SSD1309_setCOMoutputFlipped},
+    [SSD1309_ROTATE_270] = {SSD1309_setSegmentMapFlipped, SSD1309_setCOMoutputNormal},
+};
+
 /**
- *	@brief clear display buffer
+ *	@brief set the orientation of the image on the panel
  *
- *	@param[in,out] p : instance of display
+ *	Mirroring is done by the controller's segment remap and COM scan
+ *	direction, so the buffer is always stored in GDDRAM order and drawing
+ *	does not flip coordinates. SSD1309_ROTATE_90 and SSD1309_ROTATE_270 swap
+ *	width and height (see ssd1309_get_size()) and draw through a transposed
+ *	path, which is slower than the other orientations.
  *
- */
-void ssd1309_clear(ssd1309_t *p)
-{
-    memset(p->buffer, 0, p->bufsize);
-}
-
-/**
- * @brief Draw inverted pixel
+ *	The remap only applies to data written afterwards, so the whole buffer
+ *	is transmitted by the next ssd1309_show(). Switching between transposed
+ *	and non-transposed orientations clears the buffer. The clip rectangle is
+ *	reset.
  *
- * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of pixel
- * @param[in] y : y coordinate of pixel
+ *	@param[in,out] p : instance of display
+ *	@param[in] orientation : orientation
  *
  */
-void ssd1309_clear_pixel(ssd1309_t *p, uint32_t x, uint32_t y)
+void ssd1309_set_orientation(ssd1309_t *p, ssd1309_orientation_t orientation)
 {
-    if (x >= p->width || y >= p->height)
+    if ((unsigned)orientation > SSD1309_ROTATE_270)
         return;
 
-    x = p->width - x - 1;
-    y = p->height - y - 1;
+    const bool seg_flipped = _ssd1309_orientation_cmds[orientation][0] == SSD1309_setSegmentMapFlipped;
+    const bool com_flipped = _ssd1309_orientation_cmds[orientation][1] == SSD1309_setCOMoutputFlipped;
+    const bool transposed = orientation == SSD1309_ROTATE_90 || orientation == SSD1309_ROTATE_270;
+
+    ssd1309_scroll_stop(p, 0);
+
+    // Keep the image on the same segments and COM lines for panels smaller than the GDDRAM
+    p->column_offset = seg_flipped ? 128 - _SSD1309_WIDTH(p) : 0;
+    p->start_line = com_flipped ? (_SSD1309_HEIGHT(p) - SSD1309_MAX_PAGES * 8) & 0x3F : 0;
+
+    uint8_t cmds[] = {
+        _ssd1309_orientation_cmds[orientation][0],
+        _ssd1309_orientation_cmds[orientation][1],
+        SSD1309_setDisplayStartLine | p->start_line,
+    };
+    _ssd1309_write_commands(p, cmds, sizeof(cmds));
+
+    if (transposed != p->transposed)
+    {
+        p->transposed = transposed;
+        memset(p->buffer, 0, p->bufsize);
+    }
+    p->orientation = orientation;
+    ssd1309_reset_clip(p);
 
-    p->buffer[x + (y / 8) * p->width] &= ~(1 << (y & 7));
+    p->shadow_valid = false;
+    ssd1309_invalidate(p);
 }
 
 /**
- * @brief Draw pixel
+ *	@brief get the size of the drawing area
  *
- * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of pixel
- * @param[in] y : y coordinate of pixel
+ *	@param[in] p : instance of display
  *
+ *	@return width and height in the current orientation
  */
-void ssd1309_draw_pixel(ssd1309_t *p, uint32_t x, uint32_t y)
+vector2_t ssd1309_get_size(const ssd1309_t *p)
 {
-    if (x >= p->width || y >= p->height)
-        return;
-
-    x = p->width - x - 1;
-    y = p->height - y - 1;
-
-    p->buffer[x + (y / 8) * p->width] |= (1 << (y & 7));
+    return (vector2_t){_SSD1309_VIEW_WIDTH(p), _SSD1309_VIEW_HEIGHT(p)};
 }
 
 /**
- * @brief Invert pixel
+ *	@brief mark the whole display buffer as damaged
  *
- * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of pixel
- * @param[in] y : y coordinate of pixel
+ *	The next call to ssd1309_show() transmits the full buffer. Use this after
+ *	writing to p->buffer directly or when the controller lost its RAM content.
+ *
+ *	@param[in,out] p : instance of display
  *
  */
-void ssd1309_invert_pixel(ssd1309_t *p, uint32_t x, uint32_t y)
+void ssd1309_invalidate(ssd1309_t *p)
 {
-    if (x >= p->width || y >= p->height)
-        return;
-
-    x = p->width - x - 1;
-    y = p->height - y - 1;
-
-    p->buffer[x + (y / 8) * p->width] ^= (1 << (y & 7));
+    for (uint8_t page = 0; page < _SSD1309_PAGES(p); ++page)
+        _ssd1309_mark_dirty(p, page, 0, _SSD1309_WIDTH(p) - 1);
 }
 
 /**
- * @brief Draw line
+ *	@brief clear display buffer
  *
- * @param[in,out] p : instance of display
- * @param[in] x1 : x coordinate of first point
- * @param[in] y1 : y coordinate of first point
- * @param[in] x2 : x coordinate of second point
- * @param[in] y2 : y coordinate of second point
+ *	@param[in,out] p : instance of display
  *
  */
-void ssd1309_draw_line(ssd1309_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+void ssd1309_clear(ssd1309_t *p)
 {
-    if (x1 > x2)
-    {
-        _swap(&x1, &x2);
-        _swap(&y1, &y2);
-    }
+    memset(p->buffer, 0, p->bufsize);
+    ssd1309_invalidate(p);
+}
 
-    if (x1 == x2)
+/**
+ * @brief Limit the clip rectangle to the page held by a strip and mark it empty if nothing remains
+ */
+static void _ssd1309_limit_clip(ssd1309_t *p)
+{
+    if (p->strips != 0)
     {
-        if (y1 > y2)
-            _swap(&y1, &y2);
-        for (int32_t i = y1; i <= y2; ++i)
-            ssd1309_draw_pixel(p, x1, i);
-        return;
+        // The page is a band of rows, or of columns when transposed
+        int16_t *lo = p->transposed ? &p->clip_x0 : &p->clip_y0;
+        int16_t *hi = p->transposed ? &p->clip_x1 : &p->clip_y1;
+        const int16_t band = p->buffer_page == SSD1309_NO_BUFFER ? -16 : p->buffer_page * 8;
+        if (*lo < band)
+            *lo = band;
+        if (*hi > band + 7)
+            *hi = band + 7;
     }
 
-    float m = (float)(y2 - y1) / (float)(x2 - x1);
-
-    for (int32_t i = x1; i <= x2; ++i)
+    if (p->clip_x0 > p->clip_x1 || p->clip_y0 > p->clip_y1)
     {
-        float y = m * (float)(i - x1) + (float)y1;
-        ssd1309_draw_pixel(p, i, (uint32_t)y);
+        p->clip_x0 = p->clip_y0 = 0;
+        p->clip_x1 = p->clip_y1 = -1;
     }
 }
 
 /**
- * @brief Draw square
+ * @brief Restrict drawing to a rectangle
+ *
+ * All drawing functions only change pixels inside the rectangle, clipped to
+ * the display. ssd1309_clear() still clears the whole buffer. In strip mode
+ * the rectangle is also limited to the page being rendered.
  *
  * @param[in,out] p : instance of display
  * @param[in] x : x coordinate of top left corner
  * @param[in] y : y coordinate of top left corner
- * @param[in] width : width of square
- * @param[in] height : height of square
+ * @param[in] width : width of rectangle
+ * @param[in] height : height of rectangle
  *
  */
-void ssd1309_draw_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+void ssd1309_set_clip(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height)
 {
-    for (uint32_t i = 0; i < width; ++i)
-        for (uint32_t j = 0; j < height; ++j)
-            ssd1309_draw_pixel(p, x + i, y + j);
+    const int64_t x1 = (int64_t)x + width - 1;
+    const int64_t y1 = (int64_t)y + height - 1;
+
+    const int32_t width_max = _SSD1309_VIEW_WIDTH(p);
+    const int32_t height_max = _SSD1309_VIEW_HEIGHT(p);
+
+    p->clip_x0 = x < 0 ? 0 : (x > width_max ? width_max : x);
+    p->clip_y0 = y < 0 ? 0 : (y > height_max ? height_max : y);
+    p->clip_x1 = x1 >= width_max ? width_max - 1 : (int16_t)(x1 < -1 ? -1 : x1);
+    p->clip_y1 = y1 >= height_max ? height_max - 1 : (int16_t)(y1 < -1 ? -1 : y1);
+
+    _ssd1309_limit_clip(p);
 }
 
 /**
- * @brief Draw empty square
+ * @brief Allow drawing to the whole display again
  *
  * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of top left corner
- * @param[in] y : y coordinate of top left corner
- * @param[in] width : width of square
- * @param[in] height : height of square
  *
  */
-void ssd1309_draw_empty_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+void ssd1309_reset_clip(ssd1309_t *p)
 {
-    ssd1309_draw_line(p, x, y, x + width, y);
-    ssd1309_draw_line(p, x, y + height, x + width, y + height);
-    ssd1309_draw_line(p, x, y, x, y + height);
-    ssd1309_draw_line(p, x + width, y, x + width, y + height);
+    p->clip_x0 = 0;
+    p->clip_y0 = 0;
+    p->clip_x1 = _SSD1309_VIEW_WIDTH(p) - 1;
+    p->clip_y1 = _SSD1309_VIEW_HEIGHT(p) - 1;
+    _ssd1309_limit_clip(p);
 }
 
 /**
- * @brief Invert square
+ * @brief Clip an inclusive rectangle to the clip rectangle
  *
- * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of top left corner
- * @param[in] y : y coordinate of top left corner
- * @param[in] width : width of square
- * @param[in] height : height of square
+ * Coordinates are interpreted as signed, so rectangles starting left of or
+ * above the display (e.g. the block cursor at 0/0) are clipped instead of
+ * dropped.
  *
+ * @return false if nothing remains
  */
-void ssd1309_invert_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+static bool _ssd1309_clip_rect(ssd1309_t *p, int32_t *x0, int32_t *y0, int32_t *x1, int32_t *y1)
 {
-    for (uint32_t i = 0; i < width; ++i)
-        for (uint32_t j = 0; j < height; ++j)
-            ssd1309_invert_pixel(p, x + i, y + j);
+    if (*x0 < p->clip_x0)
+        *x0 = p->clip_x0;
+    if (*y0 < p->clip_y0)
+        *y0 = p->clip_y0;
+    if (*x1 > p->clip_x1)
+        *x1 = p->clip_x1;
+    if (*y1 > p->clip_y1)
+        *y1 = p->clip_y1;
+
+    return *x0 <= *x1 && *y0 <= *y1;
 }
 
-/**
- * @brief Draw char using Adafruit GFX font
- *
- * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of top left corner
- * @param[in] y : y coordinate of top left corner
- * @param[in] scale : scale of char
- * @param[in] font : font to use
- * @param[in] c : char to draw
- * 
- * @return width of char
- *
- */
-uint8_t ssd1309_draw_char_with_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const GFXfont font, char c)
+static bool _ssd1309_clip_size(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height, int32_t *x0, int32_t *y0, int32_t *x1, int32_t *y1)
 {
-    if (c < font.first || c > font.last)
-        return 0;
+    if (width == 0 || height == 0)
+        return false;
 
-    const GFXglyph glyph = font.glyph[(uint8_t)c - font.first];
-    const uint8_t *bitmap = font.bitmap + glyph.bitmapOffset;
+    const int64_t right = (int64_t)(int32_t)x + width - 1;
+    const int64_t bottom = (int64_t)(int32_t)y + height - 1;
 
-    for (uint8_t xpos = 0; xpos < glyph.width; xpos++) {
-        for (uint8_t ypos = 0; ypos < glyph.height; ypos++) {
-            int bitIndex = ypos * glyph.width + xpos;
-            if (bitmap[bitIndex / 8] & (1 << (7 - bitIndex % 8))) {
-                if (scale == 1)
-                {
-                    ssd1309_draw_pixel(p, x + xpos + glyph.xOffset, y + ypos + glyph.yOffset);
-                }
-                else
-                {
-                    ssd1309_draw_square(p, x + (xpos + glyph.xOffset) * scale, y + (ypos + glyph.yOffset) * scale, scale, scale);
-                }
-            }
-        }
-    }
+    *x0 = (int32_t)x;
+    *y0 = (int32_t)y;
+    *x1 = right > INT32_MAX ? INT32_MAX : (int32_t)right;
+    *y1 = bottom > INT32_MAX ? INT32_MAX : (int32_t)bottom;
 
-    return glyph.xAdvance;
+    return _ssd1309_clip_rect(p, x0, y0, x1, y1);
 }
 
 /**
- * @brief Draw string using Adafruit GFX font
- *
- * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of top left corner
- * @param[in] y : y coordinate of top left corner
- * @param[in] scale : scale of char
- * @param[in] font : font to use
- * @param[in] s : string to draw
+ * @brief Apply an operation to a clipped rectangle, one page row at a time
  *
+ * Partial pages at the top and bottom use a bit mask, the pages in between
+ * are written as whole bytes. A transposed rectangle is a rectangle of the
+ * buffer as well, so it only needs its coordinates swapped.
  */
-void ssd1309_draw_string_with_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const GFXfont font, const char *s)
+static void _ssd1309_fill_rect(ssd1309_t *p, int32_t x0, int32_t y0, int32_t x1, int32_t y1, _ssd1309_op_t op)
 {
-    uint8_t x_n = x;
-    for (; *s; s++)
+    if (p->transposed)
+    {
+        _swap(&x0, &y0);
+        _swap(&x1, &y1);
+    }
+
+    const uint8_t bx0 = x0;
+    const uint8_t bx1 = x1;
+    const uint8_t by0 = y0;
+    const uint8_t by1 = y1;
+    const uint8_t n = bx1 - bx0 + 1;
+
+    for (uint8_t page = by0 / 8; page <= by1 / 8; ++page)
     {
-        x_n += ssd1309_draw_char_with_font(p, x_n, y, scale, font, *s) * scale;
+        uint8_t mask = 0xFF;
+        if (page == by0 / 8)
+            mask &= 0xFF << (by0 & 7);
+        if (page == by1 / 8)
+            mask &= 0xFF >> (7 - (by1 & 7));
+
+        uint8_t *row = _SSD1309_ROW(p, page) + bx0;
+        switch (op)
+        {
+        case _SSD1309_OP_SET:
+            if (mask == 0xFF)
+                memset(row, 0xFF, n);
+            else
+                for (uint8_t i = 0; i < n; ++i)
+                    row[i] |= mask;
+            break;
+        case _SSD1309_OP_CLEAR:
+            if (mask == 0xFF)
+                memset(row, 0x00, n);
+            else
+                for (uint8_t i = 0; i < n; ++i)
+                    row[i] &= ~mask;
+            break;
+        case _SSD1309_OP_INVERT:
+            for (uint8_t i = 0; i < n; ++i)
+                row[i] ^= mask;
+            break;
+        }
+
+        _ssd1309_mark_dirty(p, page, bx0, bx1);
     }
 }
 
 /**
- * @brief Draw char using default font
- *
- * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of top left corner
- * @param[in] y : y coordinate of top left corner
- * @param[in] scale : scale of char
- * @param[in] c : char to draw
+ * @brief Draw a horizontal or vertical span, clipped to the display
  *
+ * Horizontal spans OR one bit mask across the columns, vertical spans write
+ * whole page bytes.
  */
-void ssd1309_draw_char(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, char c)
+inline static void _ssd1309_span(ssd1309_t *p, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
 {
-    ssd1309_draw_char_with_font(p, x, y, scale, SSD1309_DEFAULT_FONT, c);
+    if (_ssd1309_clip_rect(p, &x0, &y0, &x1, &y1))
+        _ssd1309_fill_rect(p, x0, y0, x1, y1, _SSD1309_OP_SET);
 }
 
-/**
- * @brief Draw string using default font
- *
+inline static void _ssd1309_apply(uint8_t *byte, uint8_t b, _ssd1309_op_t op)
+{
+    switch (op)
+    {
+    case _SSD1309_OP_SET:
+        *byte |= b;
+        break;
+    case _SSD1309_OP_CLEAR:
+        *byte &= ~b;
+        break;
+    case _SSD1309_OP_INVERT:
+        *byte ^= b;
+        break;
+    }
+}
+
+/**
+ * @brief Apply a vertical strip of up to 32 pixels to one column
+ *
+ * Bit i of bits is the pixel at (x, y + i). The strip is shifted into place
+ * and written to the one or more pages it covers as whole bytes. When
+ * transposed, the strip is a row of the buffer and is written bit by bit.
+ */
+static void _ssd1309_blit_column(ssd1309_t *p, int32_t x, int32_t y, uint32_t bits, uint8_t h, _ssd1309_op_t op)
+{
+    if (x < p->clip_x0 || x > p->clip_x1 || y > p->clip_y1 || y + h <= p->clip_y0)
+        return;
+
+    // Drop the rows outside of the clip rectangle
+    if (y < p->clip_y0)
+        bits &= UINT32_MAX << (p->clip_y0 - y);
+    if (y + h - 1 > p->clip_y1)
+        bits &= UINT32_MAX >> (31 - (p->clip_y1 - y));
+
+    // The rows above the display were dropped, so less than h rows are skipped
+    if (y < 0)
+    {
+        bits >>= -y;
+        y = 0;
+    }
+    if (bits == 0)
+        return;
+
+    if (p->transposed)
+    {
+        const uint8_t page = x / 8;
+        const uint8_t b = 1 << (x & 7);
+        uint8_t *row = _SSD1309_ROW(p, page);
+        int16_t first = -1, last = -1;
+        for (uint8_t i = 0; i < 32 && (bits >> i) != 0; ++i)
+            if (bits & ((uint32_t)1 << i))
+            {
+                _ssd1309_apply(&row[y + i], b, op);
+                if (first < 0)
+                    first = y + i;
+                last = y + i;
+            }
+        _ssd1309_mark_dirty(p, page, first, last);
+        return;
+    }
+
+    uint64_t v = (uint64_t)bits << (y & 7);
+    for (uint8_t page = y / 8; v != 0 && page < _SSD1309_PAGES(p); ++page, v >>= 8)
+    {
+        const uint8_t b = (uint8_t)v;
+        if (b == 0)
+            continue;
+
+        _ssd1309_apply(&_SSD1309_ROW(p, page)[x], b, op);
+        _ssd1309_mark_dirty(p, page, x, x);
+    }
+}
+
+/**
+ * @brief Transpose a tile of a row-major GFX glyph bitmap into column strips
+ *
+ * Bit r of cols[c] is the pixel in row r0 + r and column c0 + c. The bitmap
+ * is read sequentially, one byte at a time.
+ */
+static void _ssd1309_glyph_columns(const uint8_t *bitmap, uint8_t width, uint8_t r0, uint8_t rows, uint8_t c0, uint8_t n, uint32_t *cols)
+{
+    memset(cols, 0, n * sizeof(cols[0]));
+
+    for (uint8_t r = 0; r < rows; ++r)
+    {
+        const uint32_t bit = (uint32_t)(r0 + r) * width + c0;
+        const uint8_t *src = bitmap + bit / 8;
+        uint8_t mask = 0x80 >> (bit & 7);
+        uint8_t byte = *src;
+
+        for (uint8_t c = 0; c < n; ++c)
+        {
+            if (byte & mask)
+                cols[c] |= (uint32_t)1 << r;
+            mask >>= 1;
+            if (mask == 0 && c + 1 < n)
+            {
+                byte = *++src;
+                mask = 0x80;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Apply a row-major GFX glyph bitmap as column strips
+ *
+ * The bitmap is transposed into columns of up to 32 rows, each of which is
+ * applied with a single _ssd1309_blit_column() call.
+ */
+static void _ssd1309_blit_glyph(ssd1309_t *p, int32_t x, int32_t y, const uint8_t *bitmap, uint8_t width, uint8_t height, _ssd1309_op_t op)
+{
+    uint32_t cols[32];
+
+    for (uint8_t r0 = 0; r0 < height; r0 += 32)
+    {
+        const uint8_t rows = height - r0 < 32 ? height - r0 : 32;
+        for (uint8_t c0 = 0; c0 < width; c0 += 32)
+        {
+            const uint8_t n = width - c0 < 32 ? width - c0 : 32;
+            _ssd1309_glyph_columns(bitmap, width, r0, rows, c0, n, cols);
+
+            for (uint8_t c = 0; c < n; ++c)
+                if (cols[c])
+                    _ssd1309_blit_column(p, x + c0 + c, y + r0, cols[c], rows, op);
+        }
+    }
+}
+
+// Each nibble with every bit repeated 2, 3 or 4 times
+static const uint8_t _ssd1309_expand2[16] = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF};
+static const uint16_t _ssd1309_expand3[16] = {
+    0x000, 0x007, 0x038, 0x03F, 0x1C0, 0x1C7, 0x1F8, 0x1FF,
+    0xE00, 0xE07, 0xE38, 0xE3F, 0xFC0, 0xFC7, 0xFF8, 0xFFF};
+static const uint16_t _ssd1309_expand4[16] = {
+    0x0000, 0x000F, 0x00F0, 0x00FF, 0x0F00, 0x0F0F, 0x0FF0, 0x0FFF,
+    0xF000, 0xF00F, 0xF0F0, 0xF0FF, 0xFF00, 0xFF0F, 0xFFF0, 0xFFFF};
+
+inline static uint32_t _ssd1309_expand_byte(uint8_t b, uint32_t scale)
+{
+    switch (scale)
+    {
+    case 2:
+        return _ssd1309_expand2[b & 0x0F] | (uint32_t)_ssd1309_expand2[b >> 4] << 8;
+    case 3:
+        return _ssd1309_expand3[b & 0x0F] | (uint32_t)_ssd1309_expand3[b >> 4] << 12;
+    default:
+        return _ssd1309_expand4[b & 0x0F] | (uint32_t)_ssd1309_expand4[b >> 4] << 16;
+    }
+}
+
+/**
+ * @brief Apply a vertical strip of up to 32 pixels scaled by scale
+ *
+ * Bit i of bits is the scale x scale block at (x, y + i * scale). For scales
+ * 2 to 4 every source byte is expanded with a lookup table and written as one
+ * column strip per output column. Larger scales fill one rectangle per run
+ * of set bits.
+ */
+static void _ssd1309_blit_scaled_column(ssd1309_t *p, int32_t x, int32_t y, uint32_t bits, uint8_t h, uint32_t scale, _ssd1309_op_t op)
+{
+    if (x > p->clip_x1 || x + (int32_t)scale <= p->clip_x0 || y > p->clip_y1 || y + (int32_t)(h * scale) <= p->clip_y0)
+        return;
+
+    if (scale <= 4)
+    {
+        for (uint8_t i = 0; i < h; i += 8)
+        {
+            const uint8_t b = (uint8_t)(bits >> i);
+            if (b == 0)
+                continue;
+
+            const uint8_t rows = h - i < 8 ? h - i : 8;
+            const uint32_t strip = _ssd1309_expand_byte(b, scale);
+            for (uint32_t k = 0; k < scale; ++k)
+                _ssd1309_blit_column(p, x + (int32_t)k, y + (int32_t)(i * scale), strip, rows * scale, op);
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < h; ++i)
+    {
+        if (!(bits & ((uint32_t)1 << i)))
+            continue;
+
+        const uint8_t start = i;
+        while (i + 1 < h && (bits & ((uint32_t)1 << (i + 1))))
+            ++i;
+
+        int32_t x0 = x, y0 = y + (int32_t)(start * scale);
+        int32_t x1 = x + (int32_t)scale - 1, y1 = y + (int32_t)((i + 1) * scale) - 1;
+        if (_ssd1309_clip_rect(p, &x0, &y0, &x1, &y1))
+            _ssd1309_fill_rect(p, x0, y0, x1, y1, op);
+    }
+}
+
+/**
+ * @brief Mask of the display rows y0 to y1 (inclusive) of a column
+ */
+inline static uint64_t _ssd1309_rows(int64_t y0, int64_t y1)
+{
+    if (y0 < 0)
+        y0 = 0;
+    if (y1 > 63)
+        y1 = 63;
+    if (y0 > y1)
+        return 0;
+    return (UINT64_MAX >> (63 - (y1 - y0))) << y0;
+}
+
+/**
+ * @brief Replace the pixels of one column selected by mask with bits
+ *
+ * Bit j of bits and mask is the pixel at (x, base + j), so 64 rows of a
+ * column are written with one masked write per page byte. base is a
+ * multiple of 64, it is only non-zero for the (up to 128 rows high)
+ * transposed orientations, which write bit by bit.
+ */
+static void _ssd1309_write_column(ssd1309_t *p, int32_t x, int32_t base, uint64_t bits, uint64_t mask)
+{
+    if (x < p->clip_x0 || x > p->clip_x1)
+        return;
+
+    mask &= _ssd1309_rows((int64_t)p->clip_y0 - base, (int64_t)p->clip_y1 - base);
+    if (mask == 0)
+        return;
+    bits &= mask;
+
+    if (p->transposed)
+    {
+        const uint8_t page = x / 8;
+        const uint8_t b = 1 << (x & 7);
+        uint8_t *row = _SSD1309_ROW(p, page) + base;
+        int16_t first = -1, last = -1;
+        for (uint8_t j = 0; j < 64 && (mask >> j) != 0; ++j)
+            if (mask & ((uint64_t)1 << j))
+            {
+                row[j] = (bits & ((uint64_t)1 << j)) ? row[j] | b : row[j] & ~b;
+                if (first < 0)
+                    first = base + j;
+                last = base + j;
+            }
+        _ssd1309_mark_dirty(p, page, first, last);
+        return;
+    }
+
+    for (uint8_t page = base / 8; mask != 0 && page < _SSD1309_PAGES(p); ++page, bits >>= 8, mask >>= 8)
+    {
+        const uint8_t m = (uint8_t)mask;
+        if (m == 0)
+            continue;
+
+        uint8_t *byte = &_SSD1309_ROW(p, page)[x];
+        *byte = (*byte & ~m) | (uint8_t)bits;
+        _ssd1309_mark_dirty(p, page, x, x);
+    }
+}
+
+/**
+ * @brief Place a glyph column of h rows with its top row at display row y, every row repeated scale times
+ */
+static uint64_t _ssd1309_place_column(uint32_t bits, uint8_t h, int64_t y, uint32_t scale)
+{
+    uint64_t column = 0;
+    for (uint8_t i = 0; i < h;)
+    {
+        if (!(bits & ((uint32_t)1 << i)))
+        {
+            ++i;
+            continue;
+        }
+
+        const uint8_t start = i;
+        while (i < h && (bits & ((uint32_t)1 << i)))
+            ++i;
+        column |= _ssd1309_rows(y + (int64_t)start * scale, y + (int64_t)i * scale - 1);
+    }
+    return column;
+}
+
+/**
+ * @brief Glyph of either font format, as needed to draw it as an opaque cell
+ */
+typedef struct
+{
+    const uint8_t *data; /** GFX bitmap or page-major columns */
+    bool packed;         /** data holds page-major columns */
+    uint8_t width;
+    uint8_t height;
+    uint8_t advance;
+    int8_t x_offset;
+    int8_t y_offset;
+} _ssd1309_cell_glyph_t;
+
+static uint32_t _ssd1309_cell_glyph_column(const _ssd1309_cell_glyph_t *g, uint8_t c, uint8_t r0, uint8_t rows)
+{
+    uint32_t bits = 0;
+    if (g->packed)
+    {
+        const uint8_t bytes = (g->height + 7) / 8;
+        const uint8_t *column = g->data + c * bytes;
+        for (uint8_t i = 0; i < 4 && r0 / 8 + i < bytes; ++i)
+            bits |= (uint32_t)column[r0 / 8 + i] << (8 * i);
+    }
+    else
+        _ssd1309_glyph_columns(g->data, g->width, r0, rows, c, 1, &bits);
+    return bits;
+}
+
+/**
+ * @brief Draw a glyph together with its background cell
+ *
+ * The cell spans the advance (and the glyph, if it overhangs) horizontally
+ * and the rows top to bottom of the font (relative to the baseline)
+ * vertically. Every cell column is written with one masked write, glyph
+ * pixels set and background cleared, or the other way around if inverted.
+ * Displays higher than 64 rows (transposed) are written in bands of 64 rows.
+ */
+static void _ssd1309_draw_cell(ssd1309_t *p, int32_t x, int32_t y, uint32_t scale, const _ssd1309_cell_glyph_t *g, int8_t top, int8_t bottom, bool inverted)
+{
+    const int64_t s = scale;
+    const int64_t gx = x + s * g->x_offset;
+    const int64_t gy = y + s * g->y_offset;
+    const int64_t right = g->x_offset + g->width > g->advance ? g->x_offset + g->width : g->advance;
+    int64_t cx0 = x + s * (g->x_offset < 0 ? g->x_offset : 0);
+    int64_t cx1 = x + s * right - 1;
+
+    if (cx0 < p->clip_x0)
+        cx0 = p->clip_x0;
+    if (cx1 > p->clip_x1)
+        cx1 = p->clip_x1;
+
+    for (int32_t base = 0; base < _SSD1309_VIEW_HEIGHT(p); base += 64)
+    {
+        const uint64_t mask = _ssd1309_rows(y + s * top - base, y + s * bottom - 1 - base);
+        if (mask == 0)
+            continue;
+
+        int64_t last = -1;
+        uint64_t bits = 0;
+        for (int64_t cx = cx0; cx <= cx1; ++cx)
+        {
+            // Columns of a scaled glyph repeat, so each glyph column is only placed once
+            const int64_t c = cx >= gx ? (cx - gx) / s : -1;
+            if (c != last)
+            {
+                last = c;
+                bits = 0;
+                for (uint8_t r0 = 0; c >= 0 && c < g->width && r0 < g->height && gy + s * r0 - base < 64; r0 += 32)
+                {
+                    const uint8_t rows = g->height - r0 < 32 ? g->height - r0 : 32;
+                    bits |= _ssd1309_place_column(_ssd1309_cell_glyph_column(g, (uint8_t)c, r0, rows), rows, gy + s * r0 - base, scale);
+                }
+            }
+
+            _ssd1309_write_column(p, (int32_t)cx, base, inverted ? ~bits : bits, mask);
+        }
+    }
+}
+
+static uint8_t _ssd1309_outcode(int32_t x, int32_t y, int32_t xmin, int32_t ymin, int32_t xmax, int32_t ymax)
+{
+    uint8_t code = 0;
+    if (x < xmin)
+        code |= 1;
+    else if (x > xmax)
+        code |= 2;
+    if (y < ymin)
+        code |= 4;
+    else if (y > ymax)
+        code |= 8;
+    return code;
+}
+
+inline static int64_t _ssd1309_muldiv(int64_t a, int64_t t, int64_t b)
+{
+    // a * t / b for |t| <= |b| without overflowing 64 bits
+    const int64_t r = a % b;
+    const uint64_t rt = (uint64_t)(r < 0 ? -r : r) * (uint64_t)(t < 0 ? -t : t) / (uint64_t)(b < 0 ? -b : b);
+    const bool negative = ((r < 0) != (t < 0)) != (b < 0);
+    return (a / b) * t + (negative ? -(int64_t)rt : (int64_t)rt);
+}
+
+/**
+ * @brief Clip a line to a box (Cohen-Sutherland)
+ *
+ * @return false if the line lies completely outside
+ */
+static bool _ssd1309_clip_line(int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2, int32_t xmin, int32_t ymin, int32_t xmax, int32_t ymax)
+{
+    uint8_t code1 = _ssd1309_outcode(*x1, *y1, xmin, ymin, xmax, ymax);
+    uint8_t code2 = _ssd1309_outcode(*x2, *y2, xmin, ymin, xmax, ymax);
+
+    while (code1 | code2)
+    {
+        if (code1 & code2)
+            return false;
+
+        const uint8_t code = code1 ? code1 : code2;
+        const int64_t dx = (int64_t)*x2 - *x1;
+        const int64_t dy = (int64_t)*y2 - *y1;
+        int32_t x, y;
+
+        if (code & 12)
+        {
+            y = code & 8 ? ymax : ymin;
+            x = (int32_t)(*x1 + _ssd1309_muldiv(dx, (int64_t)y - *y1, dy));
+        }
+        else
+        {
+            x = code & 2 ? xmax : xmin;
+            y = (int32_t)(*y1 + _ssd1309_muldiv(dy, (int64_t)x - *x1, dx));
+        }
+
+        if (code == code1)
+        {
+            *x1 = x;
+            *y1 = y;
+            code1 = _ssd1309_outcode(x, y, xmin, ymin, xmax, ymax);
+        }
+        else
+        {
+            *x2 = x;
+            *y2 = y;
+            code2 = _ssd1309_outcode(x, y, xmin, ymin, xmax, ymax);
+        }
+    }
+
+    return true;
+}
+
+inline static int64_t _ssd1309_div_floor(int64_t a, int64_t b)
+{
+    const int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+inline static bool _ssd1309_in_clip(ssd1309_t *p, uint32_t x, uint32_t y)
+{
+    // Clip rectangle lies within the display, so x and y compare as unsigned
+    return p->clip_x0 <= p->clip_x1 && p->clip_y0 <= p->clip_y1 &&
+           x >= (uint32_t)p->clip_x0 && x <= (uint32_t)p->clip_x1 && y >= (uint32_t)p->clip_y0 && y <= (uint32_t)p->clip_y1;
+}
+
+inline static void _ssd1309_pixel(ssd1309_t *p, uint32_t x, uint32_t y, _ssd1309_op_t op)
+{
+    if (p->transposed)
+    {
+        const uint32_t t = x;
+        x = y;
+        y = t;
+    }
+
+    _ssd1309_apply(&_SSD1309_ROW(p, y / 8)[x], 1 << (y & 7), op);
+    _ssd1309_mark_dirty(p, y / 8, x, x);
+}
+
+/**
+ * @brief Draw inverted pixel
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of pixel
+ * @param[in] y : y coordinate of pixel
+ *
+ */
+void ssd1309_clear_pixel(ssd1309_t *p, uint32_t x, uint32_t y)
+{
+    if (!_ssd1309_in_clip(p, x, y))
+        return;
+
+    _ssd1309_pixel(p, x, y, _SSD1309_OP_CLEAR);
+}
+
+/**
+ * @brief Draw pixel
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of pixel
+ * @param[in] y : y coordinate of pixel
+ *
+ */
+void ssd1309_draw_pixel(ssd1309_t *p, uint32_t x, uint32_t y)
+{
+    if (!_ssd1309_in_clip(p, x, y))
+        return;
+
+    _ssd1309_pixel(p, x, y, _SSD1309_OP_SET);
+}
+
+/**
+ * @brief Invert pixel
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of pixel
+ * @param[in] y : y coordinate of pixel
+ *
+ */
+void ssd1309_invert_pixel(ssd1309_t *p, uint32_t x, uint32_t y)
+{
+    if (!_ssd1309_in_clip(p, x, y))
+        return;
+
+    _ssd1309_pixel(p, x, y, _SSD1309_OP_INVERT);
+}
+
+/**
+ * @brief Draw line
+ *
+ * Integer Bresenham line. Parts outside the display are skipped without
+ * changing which pixels are set inside it.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x1 : x coordinate of first point
+ * @param[in] y1 : y coordinate of first point
+ * @param[in] x2 : x coordinate of second point
+ * @param[in] y2 : y coordinate of second point
+ *
+ */
+void ssd1309_draw_line(ssd1309_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    // Coordinates far outside the display are brought into a range where the
+    // 64 bit step arithmetic below cannot overflow
+    if (!_ssd1309_clip_line(&x1, &y1, &x2, &y2, -SSD1309_LINE_RANGE, -SSD1309_LINE_RANGE, SSD1309_LINE_RANGE, SSD1309_LINE_RANGE))
+        return;
+    if (_ssd1309_outcode(x1, y1, p->clip_x0, p->clip_y0, p->clip_x1, p->clip_y1) & _ssd1309_outcode(x2, y2, p->clip_x0, p->clip_y0, p->clip_x1, p->clip_y1))
+        return;
+
+    if (y1 == y2 || x1 == x2)
+    {
+        if (x1 > x2)
+            _swap(&x1, &x2);
+        if (y1 > y2)
+            _swap(&y1, &y2);
+        _ssd1309_span(p, x1, y1, x2, y2);
+        return;
+    }
+
+    // Step along the major axis a, the minor axis b follows Bresenham's error term
+    const bool x_major = (x2 > x1 ? x2 - x1 : x1 - x2) >= (y2 > y1 ? y2 - y1 : y1 - y2);
+    const int32_t a1 = x_major ? x1 : y1;
+    const int32_t a2 = x_major ? x2 : y2;
+    const int32_t b1 = x_major ? y1 : x1;
+    const int32_t b2 = x_major ? y2 : x2;
+    const int32_t amin = x_major ? p->clip_x0 : p->clip_y0;
+    const int32_t amax = x_major ? p->clip_x1 : p->clip_y1;
+    const int32_t bmin = x_major ? p->clip_y0 : p->clip_x0;
+    const int32_t bmax = x_major ? p->clip_y1 : p->clip_x1;
+    const int32_t sa = a1 < a2 ? 1 : -1;
+    const int32_t sb = b1 < b2 ? 1 : -1;
+    const int64_t da = (int64_t)(a2 - a1) * sa;
+    const int64_t db = (int64_t)(b2 - b1) * sb;
+
+    // After k steps, b has advanced by m(k) = floor((2 * db * k + da - 1) / (2 * da)).
+    // Clip by finding the first and last step whose pixel lies in the clip rectangle.
+    int64_t k0 = sa > 0 ? (int64_t)amin - a1 : (int64_t)a1 - amax;
+    int64_t k1 = sa > 0 ? (int64_t)amax - a1 : (int64_t)a1 - amin;
+    const int64_t mlo = sb > 0 ? (int64_t)bmin - b1 : (int64_t)b1 - bmax;
+    const int64_t mhi = sb > 0 ? (int64_t)bmax - b1 : (int64_t)b1 - bmin;
+
+    const int64_t kb0 = -_ssd1309_div_floor(-(2 * da * mlo - da + 1), 2 * db);
+    const int64_t kb1 = _ssd1309_div_floor(2 * da * (mhi + 1) - da, 2 * db);
+    if (kb0 > k0)
+        k0 = kb0;
+    if (kb1 < k1)
+        k1 = kb1;
+    if (k0 < 0)
+        k0 = 0;
+    if (k1 > da)
+        k1 = da;
+
+    int64_t m = _ssd1309_div_floor(2 * db * k0 + da - 1, 2 * da);
+    int64_t err = 2 * db - da + 2 * db * k0 - 2 * da * m;
+    int32_t a = a1 + sa * (int32_t)k0;
+    int32_t b = b1 + sb * (int32_t)m;
+
+    for (int64_t k = k0; k <= k1; ++k)
+    {
+        if (x_major)
+            _ssd1309_pixel(p, a, b, _SSD1309_OP_SET);
+        else
+            _ssd1309_pixel(p, b, a, _SSD1309_OP_SET);
+
+        if (err > 0)
+        {
+            b += sb;
+            err -= 2 * da;
+        }
+        err += 2 * db;
+        a += sa;
+    }
+}
+
+/**
+ * @brief Draw square
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] width : width of square
+ * @param[in] height : height of square
+ *
+ */
+void ssd1309_draw_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    int32_t x0, y0, x1, y1;
+    if (_ssd1309_clip_size(p, x, y, width, height, &x0, &y0, &x1, &y1))
+        _ssd1309_fill_rect(p, x0, y0, x1, y1, _SSD1309_OP_SET);
+}
+
+/**
+ * @brief Clear square
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] width : width of square
+ * @param[in] height : height of square
+ *
+ */
+void ssd1309_clear_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    int32_t x0, y0, x1, y1;
+    if (_ssd1309_clip_size(p, x, y, width, height, &x0, &y0, &x1, &y1))
+        _ssd1309_fill_rect(p, x0, y0, x1, y1, _SSD1309_OP_CLEAR);
+}
+
+/**
+ * @brief Draw empty square
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] width : width of square
+ * @param[in] height : height of square
+ *
+ */
+void ssd1309_draw_empty_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    int32_t x0 = x, y0 = y, x1 = x + width, y1 = y + height;
+    if (x0 > x1)
+        _swap(&x0, &x1);
+    if (y0 > y1)
+        _swap(&y0, &y1);
+
+    _ssd1309_span(p, x0, y0, x1, y0);
+    _ssd1309_span(p, x0, y1, x1, y1);
+    _ssd1309_span(p, x0, y0, x0, y1);
+    _ssd1309_span(p, x1, y0, x1, y1);
+}
+
+/**
+ * @brief Invert square
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] width : width of square
+ * @param[in] height : height of square
+ *
+ */
+void ssd1309_invert_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    int32_t x0, y0, x1, y1;
+    if (_ssd1309_clip_size(p, x, y, width, height, &x0, &y0, &x1, &y1))
+        _ssd1309_fill_rect(p, x0, y0, x1, y1, _SSD1309_OP_INVERT);
+}
+
+static void _ssd1309_draw_bitmap(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height, const uint8_t *bitmap, _ssd1309_op_t op)
+{
+    const uint32_t pages = (height + 7) / 8;
+    const int64_t c0 = (int64_t)p->clip_x0 - x > 0 ? (int64_t)p->clip_x0 - x : 0;
+    const int64_t c1 = (int64_t)p->clip_x1 - x < (int64_t)width - 1 ? (int64_t)p->clip_x1 - x : (int64_t)width - 1;
+
+    for (int64_t c = c0; c <= c1; ++c)
+        for (uint32_t page = 0; page < pages; page += 4)
+        {
+            // Up to four page bytes form one strip of 32 rows
+            uint32_t bits = 0;
+            for (uint8_t i = 0; i < 4 && page + i < pages; ++i)
+                bits |= (uint32_t)bitmap[c + (page + i) * width] << (8 * i);
+
+            const uint32_t rows = height - page * 8 < 32 ? height - page * 8 : 32;
+            if (rows < 32)
+                bits &= ((uint32_t)1 << rows) - 1;
+            if (bits != 0)
+                _ssd1309_blit_column(p, (int32_t)(x + c), y + (int32_t)(page * 8), bits, rows, op);
+        }
+}
+
+/**
+ * @brief Draw bitmap
+ *
+ * The bitmap is stored in display RAM order: (height + 7) / 8 rows of width
+ * bytes, bit 0 of each byte being the top pixel. Set bits are drawn, clear
+ * bits leave the buffer unchanged.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] width : width of bitmap
+ * @param[in] height : height of bitmap
+ * @param[in] bitmap : pixels of bitmap
+ *
+ */
+void ssd1309_draw_bitmap(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height, const uint8_t *bitmap)
+{
+    _ssd1309_draw_bitmap(p, x, y, width, height, bitmap, _SSD1309_OP_SET);
+}
+
+/**
+ * @brief Enable a cache of GFX glyphs converted to page bytes
+ *
+ * The first time a glyph is drawn at a given vertical offset within a page,
+ * it is transposed and shifted into page bytes and stored in the cache.
+ * Later draws only OR those bytes into the buffer. The least recently used
+ * glyphs are evicted when the entries or the data arena run out.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] cache : cache bookkeeping, or NULL to allocate it
+ * @param[in] data : data arena of size bytes, or NULL to allocate it
+ * @param[in] size : byte budget of the data arena
+ *
+ * @return bool.
+ * @retval true for Success
+ * @retval false if allocation failed
+ *
+ */
+bool ssd1309_glyph_cache_enable(ssd1309_t *p, ssd1309_glyph_cache_t *cache, uint8_t *data, uint16_t size)
+{
+    ssd1309_glyph_cache_disable(p);
+
+    uint8_t owned = 0;
+    if (cache == NULL)
+    {
+        if ((cache = (ssd1309_glyph_cache_t *)malloc(sizeof(ssd1309_glyph_cache_t))) == NULL)
+            return false;
+        owned |= 1;
+    }
+    if (data == NULL)
+    {
+        if ((data = (uint8_t *)malloc(size)) == NULL)
+        {
+            if (owned & 1)
+                free(cache);
+            return false;
+        }
+        owned |= 2;
+    }
+
+    cache->count = 0;
+    cache->owned = owned;
+    cache->data = data;
+    cache->size = size;
+    cache->used_bytes = 0;
+    cache->clock = 0;
+    p->glyph_cache = cache;
+
+    return true;
+}
+
+/**
+ * @brief Disable the glyph cache and release driver-allocated memory
+ *
+ * @param[in,out] p : instance of display
+ *
+ */
+void ssd1309_glyph_cache_disable(ssd1309_t *p)
+{
+    ssd1309_glyph_cache_t *cache = p->glyph_cache;
+    if (cache == NULL)
+        return;
+
+    p->glyph_cache = NULL;
+    if (cache->owned & 2)
+        free(cache->data);
+    if (cache->owned & 1)
+        free(cache);
+}
+
+static void _ssd1309_glyph_cache_evict(ssd1309_glyph_cache_t *cache)
+{
+    uint8_t lru = 0;
+    for (uint8_t i = 1; i < cache->count; ++i)
+        if (cache->entries[i].used < cache->entries[lru].used)
+            lru = i;
+
+    // Keep the arena compact: move the data of all later entries down
+    ssd1309_glyph_cache_entry_t *e = &cache->entries[lru];
+    const uint16_t len = e->glyph->width * e->pages;
+    memmove(cache->data + e->offset, cache->data + e->offset + len, cache->used_bytes - e->offset - len);
+    cache->used_bytes -= len;
+
+    for (uint8_t i = lru + 1; i < cache->count; ++i)
+        cache->entries[i].offset -= len;
+    memmove(e, e + 1, (cache->count - lru - 1) * sizeof(*e));
+    --(cache->count);
+}
+
+static const ssd1309_glyph_cache_entry_t *_ssd1309_glyph_cache_get(ssd1309_glyph_cache_t *cache, const GFXglyph *glyph, const uint8_t *bitmap, uint8_t shift)
+{
+    for (uint8_t i = 0; i < cache->count; ++i)
+    {
+        ssd1309_glyph_cache_entry_t *e = &cache->entries[i];
+        if (e->glyph == glyph && e->shift == shift)
+        {
+            e->used = ++(cache->clock);
+            return e;
+        }
+    }
+
+    const uint8_t pages = (shift + glyph->height + 7) / 8;
+    const uint16_t len = glyph->width * pages;
+    if (glyph->width > 32 || glyph->height > 32 || len > cache->size)
+        return NULL;
+
+    while (cache->count == SSD1309_GLYPH_CACHE_ENTRIES || cache->size - cache->used_bytes < len)
+        _ssd1309_glyph_cache_evict(cache);
+
+    ssd1309_glyph_cache_entry_t *e = &cache->entries[cache->count++];
+    e->glyph = glyph;
+    e->used = ++(cache->clock);
+    e->offset = cache->used_bytes;
+    e->shift = shift;
+    e->pages = pages;
+    cache->used_bytes += len;
+
+    uint32_t cols[32];
+    _ssd1309_glyph_columns(bitmap, glyph->width, 0, glyph->height, 0, glyph->width, cols);
+
+    uint8_t *dst = cache->data + e->offset;
+    for (uint8_t c = 0; c < glyph->width; ++c)
+    {
+        uint64_t v = (uint64_t)cols[c] << shift;
+        for (uint8_t i = 0; i < pages; ++i, v >>= 8)
+            *dst++ = (uint8_t)v;
+    }
+
+    return e;
+}
+
+/**
+ * @brief Draw a GFX glyph from the glyph cache
+ *
+ * @return false if the glyph cannot be cached
+ */
+static bool _ssd1309_glyph_cache_draw(ssd1309_t *p, const GFXglyph *glyph, const uint8_t *bitmap, int32_t x, int32_t y)
+{
+    if (glyph->width == 0 || glyph->height == 0)
+        return true;
+
+    // Glyphs outside the clip rectangle are not cached, so they cannot evict visible ones
+    if (x > p->clip_x1 || x + glyph->width - 1 < p->clip_x0 || y > p->clip_y1 || y + glyph->height - 1 < p->clip_y0 || p->clip_x0 > p->clip_x1 || p->clip_y0 > p->clip_y1)
+        return true;
+
+    const uint8_t shift = y & 7;
+    const int32_t page0 = (y - shift) / 8;
+
+    const ssd1309_glyph_cache_entry_t *e = _ssd1309_glyph_cache_get(p->glyph_cache, glyph, bitmap, shift);
+    if (e == NULL)
+        return false;
+
+    int32_t c0 = 0, c1 = glyph->width - 1;
+    if (x < p->clip_x0)
+        c0 = p->clip_x0 - x;
+    if (x + c1 > p->clip_x1)
+        c1 = p->clip_x1 - x;
+
+    const int32_t bmin = p->clip_y0;
+    const int32_t bmax = p->clip_y1;
+
+    for (uint8_t i = 0; i < e->pages; ++i)
+    {
+        const int32_t page = page0 + i;
+        if (page < bmin / 8 || page > bmax / 8 || c0 > c1)
+            continue;
+
+        uint8_t mask = 0xFF;
+        if (page == bmin / 8)
+            mask &= 0xFF << (bmin & 7);
+        if (page == bmax / 8)
+            mask &= 0xFF >> (7 - (bmax & 7));
+
+        const uint8_t *src = p->glyph_cache->data + e->offset + i;
+        uint8_t *row = _SSD1309_ROW(p, page);
+        for (int32_t c = c0; c <= c1; ++c)
+            row[x + c] |= src[c * e->pages] & mask;
+
+        _ssd1309_mark_dirty(p, page, x + c0, x + c1);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Select how glyphs are combined with the buffer
+ *
+ * SSD1309_TEXT_TRANSPARENT (default) sets the glyph pixels only.
+ * SSD1309_TEXT_OPAQUE also clears the background of each character cell
+ * (its advance wide and as high as the tallest glyph of the font), so text
+ * can be redrawn in place without clearing first. SSD1309_TEXT_INVERTED
+ * does the same with the colors swapped. SSD1309_TEXT_XOR inverts the glyph
+ * pixels, which keeps text readable on filled areas.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] mode : text mode
+ *
+ */
+void ssd1309_set_text_mode(ssd1309_t *p, ssd1309_text_mode_t mode)
+{
+    p->text_mode = mode;
+}
+
+inline static bool _ssd1309_cell_mode(const ssd1309_t *p)
+{
+    return p->text_mode == SSD1309_TEXT_OPAQUE || p->text_mode == SSD1309_TEXT_INVERTED;
+}
+
+inline static void _ssd1309_cell_extend(int8_t *top, int8_t *bottom, uint8_t height, int8_t y_offset)
+{
+    if (height == 0)
+        return;
+    if (y_offset < *top)
+        *top = y_offset;
+    if (y_offset + height > *bottom)
+        *bottom = y_offset + height > INT8_MAX ? INT8_MAX : y_offset + height;
+}
+
+inline static void _ssd1309_set_cell_font(ssd1309_t *p, const void *font, int8_t top, int8_t bottom)
+{
+    // Remember the cell rows of the last font, fonts are identified by their glyph table
+    p->cell_font = font;
+    p->cell_top = top;
+    p->cell_bottom = bottom;
+}
+
+/**
+ * @brief Make cell_top and cell_bottom describe a GFX font, its glyphs are only scanned when the font changes
+ */
+static void _ssd1309_gfx_cell_rows(ssd1309_t *p, const GFXfont *font)
+{
+    if (p->cell_font == font->glyph)
+        return;
+
+    int8_t top = 0, bottom = 0;
+    for (uint16_t i = 0; i <= font->last - font->first; ++i)
+        _ssd1309_cell_extend(&top, &bottom, font->glyph[i].height, font->glyph[i].yOffset);
+    _ssd1309_set_cell_font(p, font->glyph, top, bottom);
+}
+
+/**
+ * @brief Make cell_top and cell_bottom describe a page-major font, see _ssd1309_gfx_cell_rows()
+ */
+static void _ssd1309_packed_cell_rows(ssd1309_t *p, const ssd1309_font_t *font)
+{
+    if (p->cell_font == font->glyph)
+        return;
+
+    int8_t top = 0, bottom = 0;
+    for (uint16_t i = 0; i <= font->last - font->first; ++i)
+        _ssd1309_cell_extend(&top, &bottom, font->glyph[i].height, font->glyph[i].yOffset);
+    _ssd1309_set_cell_font(p, font->glyph, top, bottom);
+}
+
+/**
+ * @brief Draw char using Adafruit GFX font
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] scale : scale of char
+ * @param[in] font : font to use
+ * @param[in] c : char to draw
+ * 
+ * @return width of char
+ *
+ */
+uint8_t ssd1309_draw_char_with_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const GFXfont font, char c)
+{
+    if (c < font.first || c > font.last)
+        return 0;
+
+    const GFXglyph glyph = font.glyph[(uint8_t)c - font.first];
+    const uint8_t *bitmap = font.bitmap + glyph.bitmapOffset;
+
+    if (scale == 0)
+        return glyph.xAdvance;
+
+    if (_ssd1309_cell_mode(p))
+    {
+        _ssd1309_gfx_cell_rows(p, &font);
+
+        const _ssd1309_cell_glyph_t g = {bitmap, false, glyph.width, glyph.height, glyph.xAdvance, glyph.xOffset, glyph.yOffset};
+        _ssd1309_draw_cell(p, (int32_t)x, (int32_t)y, scale, &g, p->cell_top, p->cell_bottom, p->text_mode == SSD1309_TEXT_INVERTED);
+        return glyph.xAdvance;
+    }
+
+    const _ssd1309_op_t op = p->text_mode == SSD1309_TEXT_XOR ? _SSD1309_OP_INVERT : _SSD1309_OP_SET;
+    if (scale == 1)
+    {
+        const int32_t gx = (int32_t)x + glyph.xOffset;
+        const int32_t gy = (int32_t)y + glyph.yOffset;
+        if (op != _SSD1309_OP_SET || p->glyph_cache == NULL || p->transposed || !_ssd1309_glyph_cache_draw(p, &font.glyph[(uint8_t)c - font.first], bitmap, gx, gy))
+            _ssd1309_blit_glyph(p, gx, gy, bitmap, glyph.width, glyph.height, op);
+        return glyph.xAdvance;
+    }
+
+    uint32_t cols[32];
+    for (uint8_t r0 = 0; r0 < glyph.height; r0 += 32)
+    {
+        const uint8_t rows = glyph.height - r0 < 32 ? glyph.height - r0 : 32;
+        for (uint8_t c0 = 0; c0 < glyph.width; c0 += 32)
+        {
+            const uint8_t n = glyph.width - c0 < 32 ? glyph.width - c0 : 32;
+            _ssd1309_glyph_columns(bitmap, glyph.width, r0, rows, c0, n, cols);
+
+            for (uint8_t col = 0; col < n; ++col)
+                if (cols[col])
+                    _ssd1309_blit_scaled_column(p, (int32_t)x + (c0 + col + glyph.xOffset) * (int32_t)scale, (int32_t)y + (r0 + glyph.yOffset) * (int32_t)scale, cols[col], rows, scale, op);
+        }
+    }
+
+    return glyph.xAdvance;
+}
+
+inline static uint32_t _ssd1309_advance(const GFXfont *font, char c)
+{
+    return c < font->first || c > font->last ? 0 : font->glyph[(uint8_t)c - font->first].xAdvance;
+}
+
+/**
+ * @brief Draw the characters [s, end) of one line, skipping glyphs outside the clip rectangle
+ *
+ * With end == NULL, the line ends at the terminating null character. Once a
+ * glyph starts right of the clip rectangle, the rest of the line is skipped.
+ */
+static void _ssd1309_draw_line_of_text(ssd1309_t *p, int32_t x, int32_t y, uint32_t scale, const GFXfont *font, const char *s, const char *end)
+{
+    for (; s != end && *s; ++s)
+    {
+        if (*s < font->first || *s > font->last)
+            continue;
+
+        const GFXglyph *glyph = &font->glyph[(uint8_t)*s - font->first];
+        if (x + (glyph->xOffset < 0 ? glyph->xOffset : 0) * (int32_t)scale > p->clip_x1)
+            break;
+        if (_ssd1309_cell_mode(p) || x + (glyph->xOffset + glyph->width) * (int32_t)scale > p->clip_x0)
+            ssd1309_draw_char_with_font(p, x, y, scale, *font, *s);
+        x += glyph->xAdvance * scale;
+    }
+}
+
+/**
+ * @brief Draw string using Adafruit GFX font
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] scale : scale of char
+ * @param[in] font : font to use
+ * @param[in] s : string to draw
+ *
+ */
+void ssd1309_draw_string_with_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const GFXfont font, const char *s)
+{
+    _ssd1309_draw_line_of_text(p, (int32_t)x, (int32_t)y, scale, &font, s, NULL);
+}
+
+/**
+ * @brief Draw char using a page-major font generated by tools/fontconv.c
+ *
+ * Glyph columns are stored in the controller's byte order, so each column
+ * is written to the buffer without transposing bits.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] scale : scale of char
+ * @param[in] font : font to use
+ * @param[in] c : char to draw
+ *
+ * @return width of char
+ *
+ */
+uint8_t ssd1309_draw_char_with_packed_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const ssd1309_font_t font, char c)
+{
+    if (c < font.first || c > font.last)
+        return 0;
+
+    const ssd1309_glyph_t glyph = font.glyph[(uint8_t)c - font.first];
+    const uint8_t bytes = (glyph.height + 7) / 8;
+    const uint8_t *column = font.data + glyph.offset;
+
+    if (scale == 0)
+        return glyph.xAdvance;
+
+    if (_ssd1309_cell_mode(p))
+    {
+        _ssd1309_packed_cell_rows(p, &font);
+
+        const _ssd1309_cell_glyph_t g = {column, true, glyph.width, glyph.height, glyph.xAdvance, glyph.xOffset, glyph.yOffset};
+        _ssd1309_draw_cell(p, (int32_t)x, (int32_t)y, scale, &g, p->cell_top, p->cell_bottom, p->text_mode == SSD1309_TEXT_INVERTED);
+        return glyph.xAdvance;
+    }
+
+    const _ssd1309_op_t op = p->text_mode == SSD1309_TEXT_XOR ? _SSD1309_OP_INVERT : _SSD1309_OP_SET;
+
+    for (uint8_t xpos = 0; xpos < glyph.width; ++xpos, column += bytes)
+    {
+        for (uint8_t b = 0; b < bytes; b += 4)
+        {
+            uint32_t strip = 0;
+            for (uint8_t i = 0; i < 4 && b + i < bytes; ++i)
+                strip |= (uint32_t)column[b + i] << (8 * i);
+
+            const uint8_t ypos = b * 8;
+            const uint8_t rows = glyph.height - ypos < 32 ? glyph.height - ypos : 32;
+            if (scale == 1)
+                _ssd1309_blit_column(p, (int32_t)x + glyph.xOffset + xpos, (int32_t)y + glyph.yOffset + ypos, strip, rows, op);
+            else if (strip != 0)
+                _ssd1309_blit_scaled_column(p, (int32_t)x + (xpos + glyph.xOffset) * (int32_t)scale, (int32_t)y + (ypos + glyph.yOffset) * (int32_t)scale, strip, rows, scale, op);
+        }
+    }
+
+    return glyph.xAdvance;
+}
+
+/**
+ * @brief Draw string using a page-major font generated by tools/fontconv.c
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] scale : scale of char
+ * @param[in] font : font to use
+ * @param[in] s : string to draw
+ *
+ */
+void ssd1309_draw_string_with_packed_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const ssd1309_font_t font, const char *s)
+{
+    int32_t x_n = (int32_t)x;
+    for (; *s; s++)
+    {
+        if (*s < font.first || *s > font.last)
+            continue;
+
+        const ssd1309_glyph_t *glyph = &font.glyph[(uint8_t)*s - font.first];
+        if (x_n + (glyph->xOffset < 0 ? glyph->xOffset : 0) * (int32_t)scale > p->clip_x1)
+            break;
+        x_n += ssd1309_draw_char_with_packed_font(p, x_n, y, scale, font, *s) * scale;
+    }
+}
+
+/**
+ * @brief Set the font used by the functions without a font parameter
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] font : font to use, NULL for the default font
+ *
+ */
+void ssd1309_set_font(ssd1309_t *p, const GFXfont *font)
+{
+    p->font = font != NULL ? font : &SSD1309_DEFAULT_FONT;
+}
+
+/**
+ * @brief Draw char using current font
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] scale : scale of char
+ * @param[in] c : char to draw
+ *
+ */
+void ssd1309_draw_char(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, char c)
+{
+    ssd1309_draw_char_with_font(p, x, y, scale, *p->font, c);
+}
+
+/**
+ * @brief Draw string using current font
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] scale : scale of char
+ * @param[in] s : string to draw
+ *
+ */
+void ssd1309_draw_string(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *s)
+{
+    ssd1309_draw_string_with_font(p, x, y, scale, *p->font, s);
+}
+
+/**
+ * @brief Start a text stream at a pen position, using the current font
+ *
+ * Characters are drawn as they are passed to ssd1309_text_putc(), which has
+ * the signature of the output callback of callback-based formatters, so text
+ * can be formatted straight into the display without a staging buffer.
+ * '\n' moves the pen to the start of the next line.
+ *
+ * @param[out] stream : stream to start
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of the pen (left edge of the first char)
+ * @param[in] y : y coordinate of the pen (baseline for GFX fonts)
+ * @param[in] scale : scale of char
+ *
+ */
+void ssd1309_text_begin(ssd1309_text_stream_t *stream, ssd1309_t *p, int32_t x, int32_t y, uint32_t scale)
+{
+    stream->p = p;
+    stream->font = p->font;
+    stream->x = x;
+    stream->y = y;
+    stream->left = x;
+    stream->scale = scale;
+    stream->clipped = false;
+}
+
+/**
+ * @brief Draw the next character of a text stream
+ *
+ * Once the pen has left the clip rectangle to the right, the remaining
+ * characters of the line are dropped without drawing and stream->clipped is
+ * set, so producers can stop formatting until the next '\n'.
+ *
+ * @param[in] c : char to draw
+ * @param[in,out] stream : ssd1309_text_stream_t started with ssd1309_text_begin()
+ *
+ */
+void ssd1309_text_putc(char c, void *stream)
+{
+    ssd1309_text_stream_t *st = (ssd1309_text_stream_t *)stream;
+    const GFXfont *font = st->font;
+    ssd1309_t *p = st->p;
+
+    if (c == '\n')
+    {
+        st->x = st->left;
+        st->y += font->yAdvance * (int32_t)st->scale;
+        st->clipped = false;
+        return;
+    }
+    if (st->clipped || c < font->first || c > font->last)
+        return;
+
+    const GFXglyph *glyph = &font->glyph[(uint8_t)c - font->first];
+    const int32_t scale = (int32_t)st->scale;
+    if (st->x + (glyph->xOffset < 0 ? glyph->xOffset : 0) * scale > p->clip_x1)
+    {
+        st->clipped = true;
+        return;
+    }
+
+    if (_ssd1309_cell_mode(p) || (st->x + (glyph->xOffset + glyph->width) * scale > p->clip_x0 &&
+                                  st->y + glyph->yOffset * scale <= p->clip_y1 && st->y + (glyph->yOffset + glyph->height) * scale > p->clip_y0))
+        ssd1309_draw_char_with_font(p, st->x, st->y, st->scale, *font, c);
+    st->x += glyph->xAdvance * st->scale;
+}
+
+/**
+ * @brief Draw a string to a text stream
+ *
+ * @param[in,out] stream : stream started with ssd1309_text_begin()
+ * @param[in] s : string to draw
+ *
+ */
+void ssd1309_text_puts(ssd1309_text_stream_t *stream, const char *s)
+{
+    for (; *s; s++)
+        ssd1309_text_putc(*s, stream);
+}
+
+inline static uint16_t _ssd1309_clamp16(uint64_t v)
+{
+    return v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+}
+
+/**
+ * @brief Set up a numeric field
+ *
+ * The field shows a fixed-point number right-aligned in width cells of
+ * equal width, so a changed digit only affects its own cell. Set pad to '0'
+ * after initialization for leading zeros.
+ *
+ * @param[out] field : field to set up
+ * @param[in] font : font to use
+ * @param[in] x : x coordinate of the left edge of the first cell
+ * @param[in] y : y coordinate of the pen (baseline for GFX fonts)
+ * @param[in] scale : scale of char
+ * @param[in] width : number of cells, at most SSD1309_FIELD_CHARS
+ * @param[in] decimals : digits after the decimal point, value 1234 with 2 decimals shows as 12.34
+ *
+ */
+void ssd1309_field_init(ssd1309_field_t *field, const GFXfont *font, int32_t x, int32_t y, uint32_t scale, uint8_t width, uint8_t decimals)
+{
+    field->font = font;
+    field->x = x;
+    field->y = y;
+    field->scale = scale;
+    field->width = width < SSD1309_FIELD_CHARS ? width : SSD1309_FIELD_CHARS;
+    field->decimals = decimals;
+    field->pad = ' ';
+    field->valid = false;
+
+    // Cells fit the widest and tallest glyph that a field can show
+    static const char chars[] = "0123456789-.# ";
+    int32_t advance = 0, top = 0, bottom = 0;
+    for (const char *c = chars; *c; ++c)
+    {
+        if (*c < font->first || *c > font->last)
+            continue;
+
+        const GFXglyph *glyph = &font->glyph[(uint8_t)*c - font->first];
+        if (glyph->xAdvance > advance)
+            advance = glyph->xAdvance;
+        if (glyph->height != 0 && glyph->yOffset < top)
+            top = glyph->yOffset;
+        if (glyph->height != 0 && glyph->yOffset + glyph->height > bottom)
+            bottom = glyph->yOffset + glyph->height;
+    }
+
+    field->cell_width = _ssd1309_clamp16((uint64_t)advance * scale);
+    field->cell_height = _ssd1309_clamp16((uint64_t)(bottom - top) * scale);
+    field->cell_top = (int16_t)(top * (int32_t)scale);
+}
+
+/**
+ * @brief Redraw all cells of a numeric field on the next ssd1309_field_set()
+ *
+ * @param[in,out] field : field to redraw
+ *
+ */
+void ssd1309_field_invalidate(ssd1309_field_t *field)
+{
+    field->valid = false;
+}
+
+/**
+ * @brief Format a fixed-point number right-aligned into width characters
+ *
+ * @return false if the number does not fit
+ */
+static bool _ssd1309_format_fixed(char *out, uint8_t width, int32_t value, uint8_t decimals, char pad)
+{
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    int8_t i = width - 1;
+
+    // Digits from the right, at least one before the decimal point
+    for (uint8_t digits = 0; magnitude != 0 || digits <= decimals; ++digits)
+    {
+        if (digits == decimals && decimals != 0)
+        {
+            if (i < 0)
+                return false;
+            out[i--] = '.';
+        }
+        if (i < 0)
+            return false;
+        out[i--] = '0' + magnitude % 10;
+        magnitude /= 10;
+    }
+
+    if (pad == '0')
+    {
+        const int8_t sign = value < 0 ? 1 : 0;
+        if (i + 1 < sign)
+            return false;
+        while (i >= sign)
+            out[i--] = '0';
+        if (sign)
+            out[i--] = '-';
+        return true;
+    }
+
+    if (value < 0)
+    {
+        if (i < 0)
+            return false;
+        out[i--] = '-';
+    }
+    while (i >= 0)
+        out[i--] = ' ';
+
+    return true;
+}
+
+/**
+ * @brief Show a value in a numeric field
+ *
+ * The value is formatted without printf. Only the cells whose character
+ * changed since the last call are cleared and redrawn, so the damage (and
+ * with it the next ssd1309_show()) stays as small as the change. If the
+ * value does not fit, the field shows '#' in every cell.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in,out] field : field set up with ssd1309_field_init()
+ * @param[in] value : fixed-point value with field->decimals digits after the decimal point
+ *
+ */
+void ssd1309_field_set(ssd1309_t *p, ssd1309_field_t *field, int32_t value)
+{
+    char text[SSD1309_FIELD_CHARS];
+    if (!_ssd1309_format_fixed(text, field->width, value, field->decimals, field->pad))
+        memset(text, '#', field->width);
+
+    const GFXfont *font = field->font;
+    for (uint8_t i = 0; i < field->width; ++i)
+    {
+        if (field->valid && text[i] == field->text[i])
+            continue;
+
+        field->text[i] = text[i];
+        const int32_t cell = field->x + i * (int32_t)field->cell_width;
+        ssd1309_clear_square(p, cell, field->y + field->cell_top, field->cell_width, field->cell_height);
+
+        // Center the glyph in its cell
+        const int32_t advance = _ssd1309_advance(font, text[i]) * field->scale;
+        ssd1309_draw_char_with_font(p, cell + (field->cell_width - advance) / 2, field->y, field->scale, *font, text[i]);
+    }
+
+    field->valid = true;
+}
+
+/**
+ * @brief Set up a grid of character cells
+ *
+ * Cells are as wide as ' ' and as high as the line advance of the font.
+ * ssd1309_console_putc() and ssd1309_console_set() only mark the cells
+ * whose character or attributes change, ssd1309_console_flush() redraws
+ * and transmits just those. All cells start blank and dirty, so the first
+ * flush draws the whole grid.
+ *
+ * @param[in,out] con : console
+ * @param[in,out] p : instance of display
+ * @param[in] font : font to use (monospaced)
+ * @param[in] scale : scale of char
+ * @param[in] x : x coordinate of the left edge of the grid
+ * @param[in] y : y coordinate of the top edge of the grid
+ * @param[in] cells : storage of columns * rows cells
+ * @param[in] columns : cells per row
+ * @param[in] rows : number of rows
+ *
+ * @return false if the font has no ' ' or the grid is empty
+ */
+bool ssd1309_console_init(ssd1309_console_t *con, ssd1309_t *p, const GFXfont *font, uint32_t scale, int32_t x, int32_t y, ssd1309_cell_t *cells, uint8_t columns, uint8_t rows)
+{
+    const uint32_t advance = _ssd1309_advance(font, ' ');
+    if (cells == NULL || columns == 0 || rows == 0 || advance == 0 || scale == 0)
+        return false;
+
+    _ssd1309_gfx_cell_rows(p, font);
+
+    con->p = p;
+    con->font = font;
+    con->scale = scale;
+    con->x = x;
+    con->y = y;
+    con->cells = cells;
+    con->columns = columns;
+    con->rows = rows;
+    con->cell_width = _ssd1309_clamp16((uint64_t)advance * scale);
+    con->cell_height = _ssd1309_clamp16((uint64_t)font->yAdvance * scale);
+    con->baseline = _ssd1309_clamp16((uint64_t)-p->cell_top * scale);
+    con->cursor_x = 0;
+    con->cursor_y = 0;
+    con->attr = 0;
+
+    for (uint16_t i = 0; i < columns * rows; ++i)
+        cells[i] = (ssd1309_cell_t){' ', SSD1309_CELL_DIRTY};
+    con->dirty = columns * rows;
+
+    return true;
+}
+
+/**
+ * @brief Set the character and attributes of a cell
+ *
+ * The cell is only marked dirty if it changes.
+ *
+ * @param[in,out] con : console
+ * @param[in] column : column of the cell
+ * @param[in] row : row of the cell
+ * @param[in] c : character
+ * @param[in] attr : SSD1309_CELL_INVERSE and/or SSD1309_CELL_UNDERLINE
+ *
+ */
+void ssd1309_console_set(ssd1309_console_t *con, uint8_t column, uint8_t row, char c, uint8_t attr)
+{
+    if (column >= con->columns || row >= con->rows)
+        return;
+
+    ssd1309_cell_t *cell = &con->cells[row * con->columns + column];
+    attr &= ~SSD1309_CELL_DIRTY;
+    if (cell->c == c && (cell->attr & ~SSD1309_CELL_DIRTY) == attr)
+        return;
+
+    if (!(cell->attr & SSD1309_CELL_DIRTY))
+        ++(con->dirty);
+    cell->c = c;
+    cell->attr = attr | SSD1309_CELL_DIRTY;
+}
+
+/**
+ * @brief Move the cursor of a console
+ *
+ * @param[in,out] con : console
+ * @param[in] column : column of the next character
+ * @param[in] row : row of the next character
+ *
+ */
+void ssd1309_console_move(ssd1309_console_t *con, uint8_t column, uint8_t row)
+{
+    con->cursor_x = column < con->columns ? column : con->columns - 1;
+    con->cursor_y = row < con->rows ? row : con->rows - 1;
+}
+
+/**
+ * @brief Set the attributes of the characters written next
+ *
+ * @param[in,out] con : console
+ * @param[in] attr : SSD1309_CELL_INVERSE and/or SSD1309_CELL_UNDERLINE
+ *
+ */
+void ssd1309_console_set_attr(ssd1309_console_t *con, uint8_t attr)
+{
+    con->attr = attr & ~SSD1309_CELL_DIRTY;
+}
+
+static void _ssd1309_console_newline(ssd1309_console_t *con)
+{
+    con->cursor_x = 0;
+    if (con->cursor_y + 1 < con->rows)
+    {
+        ++(con->cursor_y);
+        return;
+    }
+
+    // Scroll up, only cells that differ from the one below become dirty
+    for (uint8_t row = 0; row + 1 < con->rows; ++row)
+        for (uint8_t column = 0; column < con->columns; ++column)
+        {
+            const ssd1309_cell_t *below = &con->cells[(row + 1) * con->columns + column];
+            ssd1309_console_set(con, column, row, below->c, below->attr);
+        }
+    for (uint8_t column = 0; column < con->columns; ++column)
+        ssd1309_console_set(con, column, con->rows - 1, ' ', 0);
+}
+
+/**
+ * @brief Write a character at the cursor of a console
+ *
+ * '\n' moves to the start of the next line, '\r' to the start of the
+ * current one. Lines wrap, and writing below the last row scrolls the grid
+ * up. Has the signature of the output callback of callback-based
+ * formatters, see ssd1309_text_putc().
+ *
+ * @param[in] c : character
+ * @param[in,out] console : console (ssd1309_console_t)
+ *
+ */
+void ssd1309_console_putc(char c, void *console)
+{
+    ssd1309_console_t *con = (ssd1309_console_t *)console;
+
+    if (c == '\n')
+    {
+        _ssd1309_console_newline(con);
+        return;
+    }
+    if (c == '\r')
+    {
+        con->cursor_x = 0;
+        return;
+    }
+    if (c < con->font->first || c > con->font->last)
+        return;
+
+    if (con->cursor_x == con->columns)
+        _ssd1309_console_newline(con);
+    ssd1309_console_set(con, con->cursor_x++, con->cursor_y, c, con->attr);
+}
+
+/**
+ * @brief Write a string at the cursor of a console
+ *
+ * @param[in,out] con : console
+ * @param[in] s : string
+ *
+ */
+void ssd1309_console_puts(ssd1309_console_t *con, const char *s)
+{
+    for (; *s; ++s)
+        ssd1309_console_putc(*s, con);
+}
+
+/**
+ * @brief Blank all cells of a console and move the cursor home
+ *
+ * @param[in,out] con : console
+ *
+ */
+void ssd1309_console_clear(ssd1309_console_t *con)
+{
+    for (uint8_t row = 0; row < con->rows; ++row)
+        for (uint8_t column = 0; column < con->columns; ++column)
+            ssd1309_console_set(con, column, row, ' ', 0);
+    con->cursor_x = 0;
+    con->cursor_y = 0;
+}
+
+/**
+ * @brief Draw a cell into the buffer, clipped to the cell and to clip (x0, y0, x1, y1)
+ */
+static void _ssd1309_console_draw(ssd1309_console_t *con, uint8_t column, uint8_t row, const int16_t *clip)
+{
+    ssd1309_t *p = con->p;
+    ssd1309_cell_t *cell = &con->cells[row * con->columns + column];
+    cell->attr &= ~SSD1309_CELL_DIRTY;
+    --(con->dirty);
+
+    const int32_t x = con->x + column * (int32_t)con->cell_width;
+    const int32_t y = con->y + row * (int32_t)con->cell_height;
+
+    // Glyphs overhanging the cell are clipped, so the neighbouring cells stay intact
+    p->clip_x0 = x > clip[0] ? x : clip[0];
+    p->clip_y0 = y > clip[1] ? y : clip[1];
+    p->clip_x1 = x + con->cell_width - 1 < clip[2] ? x + con->cell_width - 1 : clip[2];
+    p->clip_y1 = y + con->cell_height - 1 < clip[3] ? y + con->cell_height - 1 : clip[3];
+    if (p->clip_x0 > p->clip_x1 || p->clip_y0 > p->clip_y1)
+        return;
+
+    if (cell->attr & SSD1309_CELL_INVERSE)
+    {
+        ssd1309_draw_square(p, x, y, con->cell_width, con->cell_height);
+        p->text_mode = SSD1309_TEXT_XOR;
+    }
+    else
+    {
+        ssd1309_clear_square(p, x, y, con->cell_width, con->cell_height);
+        p->text_mode = SSD1309_TEXT_TRANSPARENT;
+    }
+
+    ssd1309_draw_char_with_font(p, x, y + con->baseline, con->scale, *con->font, cell->c);
+    if (cell->attr & SSD1309_CELL_UNDERLINE)
+        ssd1309_invert_square(p, x, y + con->cell_height - con->scale, con->cell_width, con->scale);
+}
+
+/**
+ * @brief Redraw and transmit the cells that changed
+ *
+ * Dirty cells of a row are grouped into runs, each of which is drawn and
+ * transmitted as one window of the columns and pages it covers. Clean
+ * cells between two dirty ones are sent along if that is cheaper than
+ * another window. Damage drawn outside of the console is kept for the
+ * next ssd1309_show().
+ *
+ * @param[in,out] con : console
+ *
+ */
+void ssd1309_console_flush(ssd1309_console_t *con)
+{
+    if (con->dirty == 0)
+        return;
+
+    ssd1309_t *p = con->p;
+    ssd1309_damage_t pending = p->dirty;
+    _ssd1309_damage_clear(&p->dirty);
+
+    const ssd1309_text_mode_t mode = p->text_mode;
+    const int16_t clip[4] = {p->clip_x0, p->clip_y0, p->clip_x1, p->clip_y1};
+
+    for (uint8_t row = 0; row < con->rows && con->dirty != 0; ++row)
+    {
+        const ssd1309_cell_t *cells = &con->cells[row * con->columns];
+        const int32_t y = con->y + row * (int32_t)con->cell_height;
+        const uint32_t pages = (uint32_t)(_ssd1309_div_floor(y + con->cell_height - 1, 8) - _ssd1309_div_floor(y, 8) + 1);
+
+        for (uint8_t column = 0; column < con->columns;)
+        {
+            if (!(cells[column].attr & SSD1309_CELL_DIRTY))
+            {
+                ++column;
+                continue;
+            }
+
+            uint8_t last = column;
+            for (uint8_t next = column + 1; next < con->columns; ++next)
+            {
+                if (!(cells[next].attr & SSD1309_CELL_DIRTY))
+                    continue;
+                if ((uint32_t)(next - last - 1) * con->cell_width * pages > SSD1309_WINDOW_COST)
+                    break;
+                last = next;
+            }
+
+            for (uint8_t i = column; i <= last; ++i)
+                if (cells[i].attr & SSD1309_CELL_DIRTY)
+                    _ssd1309_console_draw(con, i, row, clip);
+            ssd1309_show(p);
+
+            column = last + 1;
+        }
+    }
+
+    p->clip_x0 = clip[0];
+    p->clip_y0 = clip[1];
+    p->clip_x1 = clip[2];
+    p->clip_y1 = clip[3];
+    p->text_mode = mode;
+    _ssd1309_damage_merge(&p->dirty, &pending);
+}
+
+/**
+ * @brief Describe a rectangle node
+ *
+ * The node functions only describe a node. After changing a node that is
+ * part of a scene, call ssd1309_scene_update().
+ *
+ * @param[out] n : node
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] width : width of rectangle
+ * @param[in] height : height of rectangle
+ * @param[in] flags : SSD1309_NODE_HIDDEN, SSD1309_NODE_FILLED and/or SSD1309_NODE_INVERT
+ *
+ */
+void ssd1309_node_rect(ssd1309_node_t *n, int32_t x, int32_t y, uint32_t width, uint32_t height, uint8_t flags)
+{
+    n->type = SSD1309_NODE_RECT;
+    n->flags = flags;
+    n->x = (int16_t)x;
+    n->y = (int16_t)y;
+    n->width = (uint16_t)width;
+    n->height = (uint16_t)height;
+}
+
+/**
+ * @brief Describe a line node
+ *
+ * @param[out] n : node
+ * @param[in] x1 : x coordinate of first end
+ * @param[in] y1 : y coordinate of first end
+ * @param[in] x2 : x coordinate of second end
+ * @param[in] y2 : y coordinate of second end
+ * @param[in] flags : SSD1309_NODE_HIDDEN
+ *
+ */
+void ssd1309_node_line(ssd1309_node_t *n, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint8_t flags)
+{
+    n->type = SSD1309_NODE_LINE;
+    n->flags = flags;
+    n->x = (int16_t)x1;
+    n->y = (int16_t)y1;
+    n->x2 = (int16_t)x2;
+    n->y2 = (int16_t)y2;
+}
+
+/**
+ * @brief Describe a text node
+ *
+ * The string is not copied; after changing its content, call
+ * ssd1309_scene_update().
+ *
+ * @param[out] n : node
+ * @param[in] font : font to use, NULL for the default font
+ * @param[in] scale : scale of char
+ * @param[in] x : x coordinate of the pen
+ * @param[in] y : y coordinate of the baseline
+ * @param[in] s : string
+ * @param[in] flags : SSD1309_NODE_HIDDEN and/or SSD1309_NODE_INVERT
+ *
+ */
+void ssd1309_node_text(ssd1309_node_t *n, const GFXfont *font, uint32_t scale, int32_t x, int32_t y, const char *s, uint8_t flags)
+{
+    n->type = SSD1309_NODE_TEXT;
+    n->flags = flags;
+    n->x = (int16_t)x;
+    n->y = (int16_t)y;
+    n->font = font != NULL ? font : &SSD1309_DEFAULT_FONT;
+    n->scale = scale;
+    n->text = s;
+}
+
+/**
+ * @brief Describe a bitmap node
+ *
+ * @param[out] n : node
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] width : width of bitmap
+ * @param[in] height : height of bitmap
+ * @param[in] bitmap : pixels of bitmap, see ssd1309_draw_bitmap()
+ * @param[in] flags : SSD1309_NODE_HIDDEN and/or SSD1309_NODE_INVERT
+ *
+ */
+void ssd1309_node_bitmap(ssd1309_node_t *n, int32_t x, int32_t y, uint32_t width, uint32_t height, const uint8_t *bitmap, uint8_t flags)
+{
+    n->type = SSD1309_NODE_BITMAP;
+    n->flags = flags;
+    n->x = (int16_t)x;
+    n->y = (int16_t)y;
+    n->width = (uint16_t)width;
+    n->height = (uint16_t)height;
+    n->bitmap = bitmap;
+}
+
+/**
+ * @brief Pixels a node covers, clipped to the display
+ */
+static ssd1309_bounds_t _ssd1309_node_bounds(const ssd1309_t *p, const ssd1309_node_t *n)
+{
+    int64_t x0 = n->x, y0 = n->y, x1 = -1, y1 = -1;
+
+    switch (n->type)
+    {
+    case SSD1309_NODE_RECT:
+    case SSD1309_NODE_BITMAP:
+        // Outlines are drawn on x + width and y + height, see ssd1309_draw_empty_square()
+        x1 = x0 + n->width - (n->type == SSD1309_NODE_RECT && !(n->flags & SSD1309_NODE_FILLED) ? 0 : 1);
+        y1 = y0 + n->height - (n->type == SSD1309_NODE_RECT && !(n->flags & SSD1309_NODE_FILLED) ? 0 : 1);
+        break;
+    case SSD1309_NODE_LINE:
+        x0 = n->x < n->x2 ? n->x : n->x2;
+        y0 = n->y < n->y2 ? n->y : n->y2;
+        x1 = n->x < n->x2 ? n->x2 : n->x;
+        y1 = n->y < n->y2 ? n->y2 : n->y;
+        break;
+    case SSD1309_NODE_TEXT:
+    {
+        const ssd1309_bounds_t b = ssd1309_get_string_bounds_with_font(*n->font, n->scale, n->text);
+        x0 += b.x;
+        y0 += b.y;
+        x1 = x0 + b.width - 1;
+        y1 = y0 + b.height - 1;
+        break;
+    }
+    }
+
+    if (x0 < 0)
+        x0 = 0;
+    if (y0 < 0)
+        y0 = 0;
+    if (x1 >= _SSD1309_VIEW_WIDTH(p))
+        x1 = _SSD1309_VIEW_WIDTH(p) - 1;
+    if (y1 >= _SSD1309_VIEW_HEIGHT(p))
+        y1 = _SSD1309_VIEW_HEIGHT(p) - 1;
+
+    if ((n->flags & SSD1309_NODE_HIDDEN) || x0 > x1 || y0 > y1)
+        return (ssd1309_bounds_t){0, 0, 0, 0};
+    return (ssd1309_bounds_t){(int16_t)x0, (int16_t)y0, (uint16_t)(x1 - x0 + 1), (uint16_t)(y1 - y0 + 1)};
+}
+
+static void _ssd1309_node_draw(ssd1309_t *p, const ssd1309_node_t *n)
+{
+    const bool invert = n->flags & SSD1309_NODE_INVERT;
+
+    switch (n->type)
+    {
+    case SSD1309_NODE_RECT:
+        if (!(n->flags & SSD1309_NODE_FILLED))
+            ssd1309_draw_empty_square(p, (uint32_t)n->x, (uint32_t)n->y, n->width, n->height);
+        else if (invert)
+            ssd1309_invert_square(p, (uint32_t)n->x, (uint32_t)n->y, n->width, n->height);
+        else
+            ssd1309_draw_square(p, (uint32_t)n->x, (uint32_t)n->y, n->width, n->height);
+        break;
+    case SSD1309_NODE_LINE:
+        ssd1309_draw_line(p, n->x, n->y, n->x2, n->y2);
+        break;
+    case SSD1309_NODE_TEXT:
+        p->text_mode = invert ? SSD1309_TEXT_XOR : SSD1309_TEXT_TRANSPARENT;
+        ssd1309_draw_string_with_font(p, (uint32_t)n->x, (uint32_t)n->y, n->scale, *n->font, n->text);
+        break;
+    case SSD1309_NODE_BITMAP:
+        _ssd1309_draw_bitmap(p, n->x, n->y, n->width, n->height, n->bitmap, invert ? _SSD1309_OP_INVERT : _SSD1309_OP_SET);
+        break;
+    }
+}
+
+inline static bool _ssd1309_bounds_overlap(const ssd1309_bounds_t *a, const ssd1309_bounds_t *b)
+{
+    return a->x < b->x + b->width && b->x < a->x + a->width && a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+static ssd1309_bounds_t _ssd1309_bounds_union(const ssd1309_bounds_t *a, const ssd1309_bounds_t *b)
+{
+    const int16_t x0 = a->x < b->x ? a->x : b->x;
+    const int16_t y0 = a->y < b->y ? a->y : b->y;
+    const int16_t x1 = a->x + a->width > b->x + b->width ? a->x + a->width : b->x + b->width;
+    const int16_t y1 = a->y + a->height > b->y + b->height ? a->y + a->height : b->y + b->height;
+    return (ssd1309_bounds_t){x0, y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+}
+
+/**
+ * @brief Add an area to the damage of a scene, keeping the rectangles disjoint
+ */
+static void _ssd1309_scene_damage(ssd1309_scene_t *scene, ssd1309_bounds_t r)
+{
+    if (r.width == 0 || r.height == 0)
+        return;
+
+    // Overlapping rectangles are joined, so no area is redrawn twice
+    for (uint8_t i = 0; i < scene->damage_count;)
+    {
+        if (!_ssd1309_bounds_overlap(&r, &scene->damage[i]))
+        {
+            ++i;
+            continue;
+        }
+        r = _ssd1309_bounds_union(&r, &scene->damage[i]);
+        scene->damage[i] = scene->damage[--(scene->damage_count)];
+        i = 0;
+    }
+
+    if (scene->damage_count == SSD1309_SCENE_RECTS)
+    {
+        // Out of rectangles, join the one that grows the least
+        uint8_t best = 0;
+        uint32_t growth = UINT32_MAX;
+        for (uint8_t i = 0; i < scene->damage_count; ++i)
+        {
+            const ssd1309_bounds_t u = _ssd1309_bounds_union(&r, &scene->damage[i]);
+            const uint32_t g = (uint32_t)u.width * u.height - (uint32_t)scene->damage[i].width * scene->damage[i].height;
+            if (g < growth)
+            {
+                growth = g;
+                best = i;
+            }
+        }
+        r = _ssd1309_bounds_union(&r, &scene->damage[best]);
+        scene->damage[best] = scene->damage[--(scene->damage_count)];
+        _ssd1309_scene_damage(scene, r);
+        return;
+    }
+
+    scene->damage[scene->damage_count++] = r;
+}
+
+/**
+ * @brief Set up a display list
+ *
+ * The nodes are drawn in array order, later nodes on top. The scene owns
+ * the areas its nodes cover: ssd1309_scene_flush() clears the damaged parts
+ * of them and redraws the nodes intersecting them, drawing elsewhere on
+ * the display is left alone. The first flush draws all nodes.
+ *
+ * @param[in,out] scene : scene
+ * @param[in,out] p : instance of display
+ * @param[in,out] nodes : nodes described with the ssd1309_node_*() functions
+ * @param[in] count : number of nodes
+ *
+ */
+void ssd1309_scene_init(ssd1309_scene_t *scene, ssd1309_t *p, ssd1309_node_t *nodes, uint8_t count)
+{
+    scene->p = p;
+    scene->nodes = nodes;
+    scene->count = count;
+    scene->damage_count = 0;
+
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        nodes[i].bounds = _ssd1309_node_bounds(p, &nodes[i]);
+        _ssd1309_scene_damage(scene, nodes[i].bounds);
+    }
+}
+
+/**
+ * @brief Damage the area a node covered and the area it covers now
+ *
+ * Call after changing a node of the scene (with a ssd1309_node_*() function
+ * or by writing its fields), before the next ssd1309_scene_flush().
+ *
+ * @param[in,out] scene : scene
+ * @param[in,out] n : node of the scene
+ *
+ */
+void ssd1309_scene_update(ssd1309_scene_t *scene, ssd1309_node_t *n)
+{
+    _ssd1309_scene_damage(scene, n->bounds);
+    n->bounds = _ssd1309_node_bounds(scene->p, n);
+    _ssd1309_scene_damage(scene, n->bounds);
+}
+
+/**
+ * @brief Redraw and transmit the damaged areas of a scene
+ *
+ * Each damage rectangle is cleared and the nodes intersecting it are drawn
+ * again, clipped to it, then the display is shown. Work and bus traffic are
+ * proportional to what changed. The clip rectangle is ignored and restored.
+ *
+ * @param[in,out] scene : scene
+ *
+ */
+void ssd1309_scene_flush(ssd1309_scene_t *scene)
+{
+    ssd1309_t *p = scene->p;
+    const ssd1309_text_mode_t mode = p->text_mode;
+    const int16_t clip[4] = {p->clip_x0, p->clip_y0, p->clip_x1, p->clip_y1};
+
+    for (uint8_t i = 0; i < scene->damage_count; ++i)
+    {
+        const ssd1309_bounds_t *r = &scene->damage[i];
+        ssd1309_set_clip(p, r->x, r->y, r->width, r->height);
+        ssd1309_clear_square(p, (uint32_t)r->x, (uint32_t)r->y, r->width, r->height);
+
+        for (uint8_t j = 0; j < scene->count; ++j)
+            if (_ssd1309_bounds_overlap(&scene->nodes[j].bounds, r))
+                _ssd1309_node_draw(p, &scene->nodes[j]);
+    }
+    scene->damage_count = 0;
+
+    p->clip_x0 = clip[0];
+    p->clip_y0 = clip[1];
+    p->clip_x1 = clip[2];
+    p->clip_y1 = clip[3];
+    p->text_mode = mode;
+    ssd1309_show(p);
+}
+
+/**
+ * @brief Draw all nodes of a scene
+ *
+ * Has the signature of the draw callback of ssd1309_render(), so a scene
+ * can be shown on a display in strip mode, where ssd1309_scene_flush() is
+ * not available.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] scene : scene (ssd1309_scene_t)
+ *
+ */
+void ssd1309_scene_draw(ssd1309_t *p, void *scene)
+{
+    const ssd1309_scene_t *s = (const ssd1309_scene_t *)scene;
+    const ssd1309_text_mode_t mode = p->text_mode;
+
+    for (uint8_t i = 0; i < s->count; ++i)
+        if (!(s->nodes[i].flags & SSD1309_NODE_HIDDEN))
+            _ssd1309_node_draw(p, &s->nodes[i]);
+
+    p->text_mode = mode;
+}
+
+static vector2_t _ssd1309_size(uint32_t advance, uint8_t y_advance, uint32_t scale, bool empty)
+{
+    vector2_t size = {0, 0};
+    if (!empty)
+    {
+        size.width = _ssd1309_clamp16((uint64_t)advance * scale);
+        size.height = _ssd1309_clamp16((uint64_t)y_advance * scale);
+    }
+    return size;
+}
+
+typedef struct
+{
+    int32_t pen, x0, y0, x1, y1;
+} _ssd1309_extent_t;
+
+inline static void _ssd1309_extent_add(_ssd1309_extent_t *e, uint8_t width, uint8_t height, uint8_t advance, int8_t x_offset, int8_t y_offset)
+{
+    if (width != 0 && height != 0)
+    {
+        if (e->pen + x_offset < e->x0)
+            e->x0 = e->pen + x_offset;
+        if (e->pen + x_offset + width > e->x1)
+            e->x1 = e->pen + x_offset + width;
+        if (y_offset < e->y0)
+            e->y0 = y_offset;
+        if (y_offset + height > e->y1)
+            e->y1 = y_offset + height;
+    }
+    e->pen += advance;
+}
+
+static ssd1309_bounds_t _ssd1309_bounds(const _ssd1309_extent_t *e, uint32_t scale)
+{
+    ssd1309_bounds_t bounds = {0, 0, 0, 0};
+    if (e->x0 < e->x1 && scale != 0)
+    {
+        const int64_t x = (int64_t)e->x0 * scale;
+        const int64_t y = (int64_t)e->y0 * scale;
+        bounds.x = x < INT16_MIN ? INT16_MIN : (x > INT16_MAX ? INT16_MAX : (int16_t)x);
+        bounds.y = y < INT16_MIN ? INT16_MIN : (y > INT16_MAX ? INT16_MAX : (int16_t)y);
+        bounds.width = _ssd1309_clamp16((uint64_t)(e->x1 - e->x0) * scale);
+        bounds.height = _ssd1309_clamp16((uint64_t)(e->y1 - e->y0) * scale);
+    }
+    return bounds;
+}
+
+/**
+ * @brief Get size of string using Adafruit GFX font
+ *
+ * The width is the sum of the advances, the height the line height of the
+ * font. Characters outside of the font are skipped, like when drawing.
+ *
+ * @param[in] font : font to use
+ * @param[in] scale : scale of char
+ * @param[in] s : string to measure
+ *
+ * @return size in pixels, saturated to 65535
+ *
+ */
+vector2_t ssd1309_get_scaled_string_size_with_font(const GFXfont font, uint32_t scale, const char *s)
+{
+    uint32_t advance = 0;
+    const bool empty = *s == '\0';
+    for (; *s; s++)
+        if (*s >= font.first && *s <= font.last)
+            advance += font.glyph[(uint8_t)*s - font.first].xAdvance;
+
+    return _ssd1309_size(advance, font.yAdvance, scale, empty);
+}
+
+/**
+ * @brief Get size of string using a page-major font
+ *
+ * @param[in] font : font to use
+ * @param[in] scale : scale of char
+ * @param[in] s : string to measure
+ *
+ * @return size in pixels, saturated to 65535
+ *
+ */
+vector2_t ssd1309_get_scaled_string_size_with_packed_font(const ssd1309_font_t font, uint32_t scale, const char *s)
+{
+    uint32_t advance = 0;
+    const bool empty = *s == '\0';
+    for (; *s; s++)
+        if (*s >= font.first && *s <= font.last)
+            advance += font.glyph[(uint8_t)*s - font.first].xAdvance;
+
+    return _ssd1309_size(advance, font.yAdvance, scale, empty);
+}
+
+vector2_t ssd1309_get_string_size_with_font(const GFXfont font, const char *s)
+{
+    return ssd1309_get_scaled_string_size_with_font(font, 1, s);
+}
+
+vector2_t ssd1309_get_string_size(const char *s)
+{
+    return ssd1309_get_string_size_with_font(SSD1309_DEFAULT_FONT, s);
+}
+
+/**
+ * @brief Get box covered by the pixels of a string using Adafruit GFX font
+ *
+ * The box is relative to the position the string is drawn at, so for GFX
+ * fonts y is usually negative (glyphs are placed above the baseline).
+ *
+ * @param[in] font : font to use
+ * @param[in] scale : scale of char
+ * @param[in] s : string to measure
+ *
+ * @return bounds, width and height are 0 if no pixel would be drawn
+ *
+ */
+ssd1309_bounds_t ssd1309_get_string_bounds_with_font(const GFXfont font, uint32_t scale, const char *s)
+{
+    _ssd1309_extent_t e = {0, INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN};
+    for (; *s; s++)
+    {
+        if (*s < font.first || *s > font.last)
+            continue;
+        const GFXglyph *glyph = &font.glyph[(uint8_t)*s - font.first];
+        _ssd1309_extent_add(&e, glyph->width, glyph->height, glyph->xAdvance, glyph->xOffset, glyph->yOffset);
+    }
+
+    return _ssd1309_bounds(&e, scale);
+}
+
+/**
+ * @brief Get box covered by the pixels of a string using a page-major font
+ *
+ * @param[in] font : font to use
+ * @param[in] scale : scale of char
+ * @param[in] s : string to measure
+ *
+ * @return bounds, width and height are 0 if no pixel would be drawn
+ *
+ */
+ssd1309_bounds_t ssd1309_get_string_bounds_with_packed_font(const ssd1309_font_t font, uint32_t scale, const char *s)
+{
+    _ssd1309_extent_t e = {0, INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN};
+    for (; *s; s++)
+    {
+        if (*s < font.first || *s > font.last)
+            continue;
+        const ssd1309_glyph_t *glyph = &font.glyph[(uint8_t)*s - font.first];
+        _ssd1309_extent_add(&e, glyph->width, glyph->height, glyph->xAdvance, glyph->xOffset, glyph->yOffset);
+    }
+
+    return _ssd1309_bounds(&e, scale);
+}
+
+/**
+ * @brief Draw text into a box using Adafruit GFX font
+ *
+ * Lines are broken at '\n' and, with SSD1309_TEXT_WRAP, before the word that
+ * would cross the right edge of the box. Each line is aligned within the box
+ * and drawn clipped to it. Lines are laid out while they fit vertically (the
+ * first line is always drawn). With SSD1309_TEXT_ELLIPSIS, the last line
+ * ends in "..." if text remains, and so does every line that is too wide
+ * when not wrapping.
+ *
+ * Line breaks are found in a single pass over the text, measuring each
+ * character with one glyph table lookup.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner of box
+ * @param[in] y : y coordinate of top left corner of box
+ * @param[in] width : width of box
+ * @param[in] height : height of box
+ * @param[in] scale : scale of char
+ * @param[in] font : font to use
+ * @param[in] align : alignment of lines
+ * @param[in] flags : SSD1309_TEXT_WRAP and/or SSD1309_TEXT_ELLIPSIS
+ * @param[in] s : text to draw
+ *
+ * @return first character of the text that did not fit, or the terminating null character
+ *
+ */
+const char *ssd1309_draw_text_box_with_font(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t scale, const GFXfont font, ssd1309_align_t align, uint8_t flags, const char *s)
+{
+    if (width == 0 || height == 0 || scale == 0)
+        return s;
+
+    // Glyphs are placed relative to the baseline, which lies ascent pixels below the top of a line
+    _ssd1309_gfx_cell_rows(p, &font);
+    const int32_t ascent = -p->cell_top;
+
+    const int64_t line_height = (int64_t)font.yAdvance * scale;
+    const uint32_t dot = _ssd1309_advance(&font, '.') * scale;
+
+    // Draw within the intersection of the box and the current clip rectangle
+    const int16_t clip[4] = {p->clip_x0, p->clip_y0, p->clip_x1, p->clip_y1};
+    ssd1309_set_clip(p, x, y, width, height);
+    if (p->clip_x0 < clip[0])
+        p->clip_x0 = clip[0];
+    if (p->clip_y0 < clip[1])
+        p->clip_y0 = clip[1];
+    if (p->clip_x1 > clip[2])
+        p->clip_x1 = clip[2];
+    if (p->clip_y1 > clip[3])
+        p->clip_y1 = clip[3];
+
+    int64_t top = y;
+    while (*s)
+    {
+        // Find the end of the line and the start of the next one
+        const char *end = s, *space = NULL;
+        uint64_t w = 0, space_w = 0;
+        for (; *end && *end != '\n'; ++end)
+        {
+            const uint32_t advance = _ssd1309_advance(&font, *end) * scale;
+            if (*end == ' ')
+            {
+                space = end;
+                space_w = w;
+            }
+            if ((flags & SSD1309_TEXT_WRAP) && w + advance > width && end != s && *end != ' ')
+            {
+                if (space != NULL)
+                {
+                    end = space;
+                    w = space_w;
+                }
+                break;
+            }
+            w += advance;
+        }
+
+        const char *next = end;
+        if (*next == '\n')
+            ++next;
+        else if (flags & SSD1309_TEXT_WRAP)
+            while (*next == ' ')
+                ++next;
+
+        while (end > s && end[-1] == ' ')
+            w -= _ssd1309_advance(&font, *--end) * scale;
+
+        // Truncate to make room for the ellipsis
+        const bool last = top + 2 * line_height > (int64_t)y + height;
+        const bool ellipsis = (flags & SSD1309_TEXT_ELLIPSIS) && ((last && *next) || w > width);
+        if (ellipsis)
+        {
+            while (end > s && (w + 3 * dot > width || end[-1] == ' '))
+                w -= _ssd1309_advance(&font, *--end) * scale;
+            w += 3 * dot;
+        }
+
+        int64_t pen = x;
+        if (align == SSD1309_ALIGN_CENTER)
+            pen += ((int64_t)width - (int64_t)w) / 2;
+        else if (align == SSD1309_ALIGN_RIGHT)
+            pen += (int64_t)width - (int64_t)w;
+
+        if (top <= p->clip_y1 && top + line_height > p->clip_y0)
+        {
+            const int32_t baseline = (int32_t)(top + ascent * (int64_t)scale);
+            _ssd1309_draw_line_of_text(p, (int32_t)pen, baseline, scale, &font, s, end);
+            if (ellipsis)
+            {
+                static const char dots[] = "...";
+                for (const char *i = s; i < end; ++i)
+                    pen += _ssd1309_advance(&font, *i) * scale;
+                _ssd1309_draw_line_of_text(p, (int32_t)pen, baseline, scale, &font, dots, dots + 3);
+            }
+        }
+
+        s = next;
+        top += line_height;
+        if (last)
+            break;
+    }
+
+    p->clip_x0 = clip[0];
+    p->clip_y0 = clip[1];
+    p->clip_x1 = clip[2];
+    p->clip_y1 = clip[3];
+
+    return s;
+}
+
+/**
+ * @brief Draw text into a box using current font
+ *
+ * See ssd1309_draw_text_box_with_font().
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : x coordinate of top left corner of box
+ * @param[in] y : y coordinate of top left corner of box
+ * @param[in] width : width of box
+ * @param[in] height : height of box
+ * @param[in] scale : scale of char
+ * @param[in] align : alignment of lines
+ * @param[in] flags : SSD1309_TEXT_WRAP and/or SSD1309_TEXT_ELLIPSIS
+ * @param[in] s : text to draw
+ *
+ * @return first character of the text that did not fit, or the terminating null character
+ *
+ */
+const char *ssd1309_draw_text_box(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t scale, ssd1309_align_t align, uint8_t flags, const char *s)
+{
+    return ssd1309_draw_text_box_with_font(p, x, y, width, height, scale, *p->font, align, flags, s);
+}
+
+/**
+ * @brief Position and size of the character cell in column x and row y of the current font
+ *
+ * Cells are as wide as a space and as high as a line of the current font
+ * (6x8 pixels for the default font).
+ */
+static void _ssd1309_get_char_position_size(const ssd1309_t *p, uint32_t *x, uint32_t *y, uint32_t *width, uint32_t *height, uint32_t scale)
+{
+    *width = _ssd1309_advance(p->font, ' ') * scale;
+    *height = p->font->yAdvance * scale;
+    *x = *width * (*x);
+    *y = *height * (*y);
+}
+
+#define _SSD1309_FORMAT_LEFT 0x01  /** '-': pad on the right */
+#define _SSD1309_FORMAT_ZERO 0x02  /** '0': pad numbers with zeros */
+#define _SSD1309_FORMAT_PLUS 0x04  /** '+': sign positive numbers */
+#define _SSD1309_FORMAT_SPACE 0x08 /** ' ': space before positive numbers */
+#define _SSD1309_FORMAT_ALT 0x10   /** '#': 0x/0 prefix, decimal point always shown */
+
+/**
+ * @brief Output one converted field: prefix, zeros up to zeros digits and digits, padded to width
+ */
+static void _ssd1309_format_field(void (*out)(char c, void *ctx), void *ctx, const char *prefix, const char *digits, size_t len, size_t zeros, uint32_t width, uint8_t flags)
+{
+    const size_t pre = strlen(prefix);
+    if (zeros < len)
+        zeros = len;
+
+    size_t pad = width > pre + zeros ? width - pre - zeros : 0;
+    if ((flags & _SSD1309_FORMAT_ZERO) && !(flags & _SSD1309_FORMAT_LEFT))
+    {
+        zeros += pad;
+        pad = 0;
+    }
+
+    if (!(flags & _SSD1309_FORMAT_LEFT))
+        for (size_t i = 0; i < pad; ++i)
+            out(' ', ctx);
+    for (size_t i = 0; i < pre; ++i)
+        out(prefix[i], ctx);
+    for (size_t i = len; i < zeros; ++i)
+        out('0', ctx);
+    for (size_t i = 0; i < len; ++i)
+        out(digits[i], ctx);
+    if (flags & _SSD1309_FORMAT_LEFT)
+        for (size_t i = 0; i < pad; ++i)
+            out(' ', ctx);
+}
+
+/**
+ * @brief Write the digits of v in base to the end of buf
+ *
+ * @return first digit
+ */
+static char *_ssd1309_format_uint(char *end, uint64_t v, uint8_t base, bool upper)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    do
+    {
+        *--end = digits[v % base];
+        v /= base;
+    } while (v != 0);
+    return end;
+}
+
+/**
+ * @brief Format like vprintf(), passing each character to out
+ *
+ * Supports the flags "-0+ #", width and precision (also as '*'), the length
+ * modifiers hh, h, l, ll, z, j and t, and the conversions d, i, u, o, x, X,
+ * c, s, p, f, F and %. e, E, g and G are printed like f, with at most 16
+ * decimals. Nothing is buffered beyond the digits of one number.
+ */
+static void _ssd1309_vformat(void (*out)(char c, void *ctx), void *ctx, const char *format, va_list args)
+{
+    for (; *format; ++format)
+    {
+        if (*format != '%')
+        {
+            out(*format, ctx);
+            continue;
+        }
+
+        uint8_t flags = 0;
+        for (;; ++format)
+        {
+            const char f = format[1];
+            if (f == '-')
+                flags |= _SSD1309_FORMAT_LEFT;
+            else if (f == '0')
+                flags |= _SSD1309_FORMAT_ZERO;
+            else if (f == '+')
+                flags |= _SSD1309_FORMAT_PLUS;
+            else if (f == ' ')
+                flags |= _SSD1309_FORMAT_SPACE;
+            else if (f == '#')
+                flags |= _SSD1309_FORMAT_ALT;
+            else
+                break;
+        }
+        ++format;
+
+        uint32_t width = 0;
+        if (*format == '*')
+        {
+            const int w = va_arg(args, int);
+            if (w < 0)
+                flags |= _SSD1309_FORMAT_LEFT;
+            width = w < 0 ? 0u - (uint32_t)w : (uint32_t)w;
+            ++format;
+        }
+        else
+            for (; *format >= '0' && *format <= '9'; ++format)
+                width = width * 10 + (uint32_t)(*format - '0');
+
+        int32_t precision = -1;
+        if (*format == '.')
+        {
+            precision = 0;
+            if (*++format == '*')
+            {
+                const int pr = va_arg(args, int);
+                precision = pr < 0 ? -1 : pr;
+                ++format;
+            }
+            else
+                for (; *format >= '0' && *format <= '9'; ++format)
+                    precision = precision * 10 + (*format - '0');
+        }
+
+        // Length: 'h' counts down, 'l' up, 'z', 'j' and 't' select their own types
+        int8_t length = 0;
+        char size_type = 0;
+        for (; *format == 'h' || *format == 'l' || *format == 'z' || *format == 'j' || *format == 't'; ++format)
+        {
+            if (*format == 'h')
+                --length;
+            else if (*format == 'l')
+                ++length;
+            else
+                size_type = *format;
+        }
+
+        char buf[40];
+        char *end = buf + sizeof(buf);
+        const char conversion = *format;
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+        {
+            int64_t v;
+            if (size_type == 'z')
+                v = (int64_t)va_arg(args, size_t);
+            else if (size_type == 'j')
+                v = va_arg(args, intmax_t);
+            else if (size_type == 't')
+                v = va_arg(args, ptrdiff_t);
+            else if (length >= 2)
+                v = va_arg(args, long long);
+            else if (length == 1)
+                v = va_arg(args, long);
+            else
+                v = va_arg(args, int);
+            if (length == -1)
+                v = (short)v;
+            else if (length <= -2)
+                v = (signed char)v;
+
+            const char *prefix = v < 0 ? "-" : (flags & _SSD1309_FORMAT_PLUS) ? "+" : (flags & _SSD1309_FORMAT_SPACE) ? " " : "";
+            const uint64_t magnitude = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+            char *digits = precision == 0 && v == 0 ? end : _ssd1309_format_uint(end, magnitude, 10, false);
+            if (precision >= 0)
+                flags &= ~_SSD1309_FORMAT_ZERO;
+            _ssd1309_format_field(out, ctx, prefix, digits, (size_t)(end - digits), precision > 0 ? (size_t)precision : 0, width, flags);
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'p':
+        {
+            uint64_t v;
+            if (conversion == 'p')
+                v = (uintptr_t)va_arg(args, void *);
+            else if (size_type == 'z')
+                v = va_arg(args, size_t);
+            else if (size_type == 'j')
+                v = va_arg(args, uintmax_t);
+            else if (size_type == 't')
+                v = (uint64_t)va_arg(args, ptrdiff_t);
+            else if (length >= 2)
+                v = va_arg(args, unsigned long long);
+            else if (length == 1)
+                v = va_arg(args, unsigned long);
+            else
+                v = va_arg(args, unsigned int);
+            if (length == -1)
+                v = (unsigned short)v;
+            else if (length <= -2)
+                v = (unsigned char)v;
+
+            const uint8_t base = conversion == 'u' ? 10 : conversion == 'o' ? 8 : 16;
+            char *digits = precision == 0 && v == 0 ? end : _ssd1309_format_uint(end, v, base, conversion == 'X');
+            const char *prefix = "";
+            if (conversion == 'p' || ((flags & _SSD1309_FORMAT_ALT) && v != 0 && base == 16))
+                prefix = conversion == 'X' ? "0X" : "0x";
+            else if ((flags & _SSD1309_FORMAT_ALT) && base == 8 && (digits == end || *digits != '0'))
+                *--digits = '0';
+            if (precision >= 0)
+                flags &= ~_SSD1309_FORMAT_ZERO;
+            _ssd1309_format_field(out, ctx, prefix, digits, (size_t)(end - digits), precision > 0 ? (size_t)precision : 0, width, flags);
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        {
+            double v = va_arg(args, double);
+            const bool negative = v < 0;
+            const char *prefix = negative ? "-" : (flags & _SSD1309_FORMAT_PLUS) ? "+" : (flags & _SSD1309_FORMAT_SPACE) ? " " : "";
+            if (negative)
+                v = -v;
+
+            if (v != v || v >= 1.8e19)
+            {
+                // NaN, infinity and values beyond 64 bit integers
+                const char *text = v != v ? "nan" : "inf";
+                _ssd1309_format_field(out, ctx, prefix, text, 3, 0, width, flags & ~_SSD1309_FORMAT_ZERO);
+                break;
+            }
+
+            const uint8_t decimals = precision < 0 ? 6 : precision > 16 ? 16 : (uint8_t)precision;
+            const uint8_t exact = decimals > 9 ? 9 : decimals;
+            uint64_t scale = 1;
+            for (uint8_t i = 0; i < exact; ++i)
+                scale *= 10;
+
+            uint64_t integer = (uint64_t)v;
+            const double scaled = (v - (double)integer) * (double)scale;
+            uint64_t fraction = (uint64_t)scaled;
+
+            // Round to nearest, ties to even
+            const double rest = scaled - (double)fraction;
+            if (rest > 0.5 || (rest == 0.5 && ((exact > 0 ? fraction : integer) & 1)))
+                ++fraction;
+            if (fraction >= scale)
+            {
+                fraction -= scale;
+                ++integer;
+            }
+
+            // Digits beyond the ninth decimal are zeros
+            for (uint8_t i = exact; i < decimals; ++i)
+                *--end = '0';
+            for (uint8_t i = 0; i < exact; ++i, fraction /= 10)
+                *--end = (char)('0' + fraction % 10);
+            if (decimals > 0 || (flags & _SSD1309_FORMAT_ALT))
+                *--end = '.';
+            char *digits = _ssd1309_format_uint(end, integer, 10, false);
+            _ssd1309_format_field(out, ctx, prefix, digits, (size_t)(buf + sizeof(buf) - digits), 0, width, flags);
+            break;
+        }
+        case 'c':
+            buf[0] = (char)va_arg(args, int);
+            _ssd1309_format_field(out, ctx, "", buf, 1, 0, width, flags & ~_SSD1309_FORMAT_ZERO);
+            break;
+        case 's':
+        {
+            const char *s = va_arg(args, const char *);
+            if (s == NULL)
+                s = "(null)";
+            size_t len = 0;
+            while (s[len] && (precision < 0 || len < (size_t)precision))
+                ++len;
+            _ssd1309_format_field(out, ctx, "", s, len, 0, width, flags & ~_SSD1309_FORMAT_ZERO);
+            break;
+        }
+        case 'n':
+            (void)va_arg(args, int *);
+            break;
+        case '%':
+            out('%', ctx);
+            break;
+        case '\0':
+            return;
+        default:
+            out('%', ctx);
+            out(conversion, ctx);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Draw formatted string using current font
+ *
+ * The text is formatted straight into a text stream, character by
+ * character, so its length is not limited. See _ssd1309_vformat() for the
+ * supported conversions.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] x : column of the character cell (cells are as wide as a space of the current font)
+ * @param[in] y : row of the character cell (rows are one line of the current font high)
+ * @param[in] scale : scale of char
+ * @param[in] format : format string
+ * @param[in] ... : arguments
+ *
+ */
+void ssd1309_printf(ssd1309_t *disp, uint32_t x, uint32_t y, uint32_t scale, const char *format, ...)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    _ssd1309_get_char_position_size(disp, &x, &y, &width, &height, scale);
+
+    ssd1309_text_stream_t stream;
+    ssd1309_text_begin(&stream, disp, (int32_t)x, (int32_t)y, scale);
+
+    va_list args;
+    va_start(args, format);
+    _ssd1309_vformat(ssd1309_text_putc, &stream, format, args);
+    va_end(args);
+}
+
+void ssd1309_cursor(ssd1309_t *disp, uint32_t x, uint32_t y, uint32_t scale, enum cursor_type type)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    _ssd1309_get_char_position_size(disp, &x, &y, &width, &height, scale);
+
+    switch (type)
+    {
+    case CURSOR_NONE:
+        break;
+    case CURSOR_UNDERSCORE:
+        ssd1309_draw_line(disp, x, y + height - 1, x + width - 2, y + height - 1);
+        break;
+    case CURSOR_BLOCK:
+        ssd1309_invert_square(disp, x - 1, y - 1, width + 1, height + 1);
+        break;
+    default:
+        break;
+    }
+}
+
+static inline uint32_t _ssd1309_bmp_get_val(const uint8_t *data, const size_t offset, uint8_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return data[offset];
+    case 2:
+        return data[offset] | (data[offset + 1] << 8);
+    case 4:
+        return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((uint32_t)data[offset + 3] << 24);
+    default:
+        return 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief BMP being drawn, decoded one row at a time into bits per display column
+ */
+typedef struct
+{
+    ssd1309_t *p;
+    ssd1309_blend_t blend;
+    int32_t x;           /** left edge of the image */
+    int32_t y;           /** top edge of the image */
+    int32_t height;      /** rows of the image */
+    bool top_down;       /** first row of the file is the top row */
+    int32_t vx0;         /** first visible column */
+    int32_t vx1;         /** last visible column */
+    int32_t vy0;         /** first visible row */
+    int32_t vy1;         /** last visible row */
+    uint8_t lit[32];     /** bit per palette index, set if the colour is drawn */
+    uint8_t columns[16]; /** bit per display column, set for the visible ones */
+    uint8_t line[16];    /** row being decoded, bit per display column */
+    uint8_t band[8][16]; /** rows of the page being collected */
+    uint8_t band_rows;   /** rows of band that were decoded */
+    int32_t page;        /** page of band, -1 if empty */
+} _ssd1309_bmp_t;
+
+inline static uint8_t _ssd1309_reverse8(uint8_t b)
+{
+    b = (uint8_t)((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+    b = (uint8_t)((b & 0xCC) >> 2 | (b & 0x33) << 2);
+    return (uint8_t)((b & 0xAA) >> 1 | (b & 0x55) << 1);
+}
+
+/**
+ * @brief Transpose an 8x8 block of bits: bit j of in[i] becomes bit i of out[j]
+ */
+static void _ssd1309_transpose8(const uint8_t *in, uint8_t *out)
+{
+    uint64_t v = 0, t;
+    for (uint8_t i = 0; i < 8; ++i)
+        v |= (uint64_t)in[i] << (8 * i);
+
+    // Swap 1x1, then 2x2, then 4x4 sub-blocks across the diagonal
+    t = (v ^ (v >> 7)) & 0x00AA00AA00AA00AAULL;
+    v ^= t ^ (t << 7);
+    t = (v ^ (v >> 14)) & 0x0000CCCC0000CCCCULL;
+    v ^= t ^ (t << 14);
+    t = (v ^ (v >> 28)) & 0x00000000F0F0F0F0ULL;
+    v ^= t ^ (t << 28);
+
+    for (uint8_t j = 0; j < 8; ++j)
+        out[j] = (uint8_t)(v >> (8 * j));
+}
+
+inline static void _ssd1309_bmp_blend(const _ssd1309_bmp_t *b, uint8_t *byte, uint8_t bits, uint8_t mask)
+{
+    switch (b->blend)
+    {
+    case SSD1309_BLEND_COPY:
+        *byte = (*byte & ~mask) | bits;
+        break;
+    case SSD1309_BLEND_OR:
+        *byte |= bits;
+        break;
+    case SSD1309_BLEND_XOR:
+        *byte ^= bits;
+        break;
+    }
+}
+
+/**
+ * @brief Write the collected rows of a page to the buffer, 8 columns per transposed block
+ */
+static void _ssd1309_bmp_flush(_ssd1309_bmp_t *b)
+{
+    if (b->page < 0)
+        return;
+
+    uint8_t *row = _SSD1309_ROW(b->p, b->page);
+    for (int32_t k = b->vx0 / 8; k <= b->vx1 / 8; ++k)
+    {
+        uint8_t in[8], out[8];
+        for (uint8_t i = 0; i < 8; ++i)
+            in[i] = b->band[i][k];
+        _ssd1309_transpose8(in, out);
+
+        for (uint8_t j = 0; j < 8; ++j)
+            if (b->columns[k] & (1 << j))
+                _ssd1309_bmp_blend(b, &row[8 * k + j], out[j], b->band_rows);
+    }
+    _ssd1309_mark_dirty(b->p, b->page, b->vx0, b->vx1);
+
+    memset(b->band, 0, sizeof(b->band));
+    b->band_rows = 0;
+    b->page = -1;
+}
+
+/**
+ * @brief Hand the decoded line over as row r of the file and start the next one
+ */
+static void _ssd1309_bmp_put(_ssd1309_bmp_t *b, int32_t r)
+{
+    const int32_t y = b->y + (b->top_down ? r : b->height - 1 - r);
+    if (y >= b->vy0 && y <= b->vy1)
+    {
+        if (b->p->transposed)
+        {
+            // The row is a column of the buffer and its bytes already are page bytes
+            for (int32_t k = b->vx0 / 8; k <= b->vx1 / 8; ++k)
+            {
+                _ssd1309_bmp_blend(b, &_SSD1309_ROW(b->p, k)[y], b->line[k] & b->columns[k], b->columns[k]);
+                _ssd1309_mark_dirty(b->p, k, y, y);
+            }
+        }
+        else
+        {
+            if (y / 8 != b->page)
+            {
+                _ssd1309_bmp_flush(b);
+                b->page = y / 8;
+            }
+            for (int32_t k = b->vx0 / 8; k <= b->vx1 / 8; ++k)
+                b->band[y & 7][k] = b->line[k] & b->columns[k];
+            b->band_rows |= 1 << (y & 7);
+        }
+    }
+
+    memset(b->line, 0, sizeof(b->line));
+}
+
+inline static void _ssd1309_bmp_pixel(_ssd1309_bmp_t *b, int32_t c, uint8_t index)
+{
+    const int32_t x = b->x + c;
+    if (x >= b->vx0 && x <= b->vx1 && (b->lit[index / 8] & (1 << (index & 7))))
+        b->line[x / 8] |= 1 << (x & 7);
+}
+
+/**
+ * @brief Decode the visible pixels of an uncompressed row
+ */
+static void _ssd1309_bmp_decode_row(_ssd1309_bmp_t *b, const uint8_t *src, uint16_t bpp)
+{
+    const int32_t c0 = b->vx0 - b->x;
+    const int32_t c1 = b->vx1 - b->x;
+
+    if (bpp != 1)
+    {
+        for (int32_t c = c0; c <= c1; ++c)
+            _ssd1309_bmp_pixel(b, c, bpp == 8 ? src[c] : (src[c / 2] >> (c & 1 ? 0 : 4)) & 0x0F);
+        return;
+    }
+
+    // Eight pixels at a time: mapped through the palette, reversed to LSB first and shifted into place
+    const bool lit0 = b->lit[0] & 1;
+    const bool lit1 = b->lit[0] & 2;
+    for (int32_t m = c0 / 8; m <= c1 / 8; ++m)
+    {
+        const uint8_t v = lit1 ? (lit0 ? 0xFF : src[m]) : (lit0 ? (uint8_t)~src[m] : 0);
+        const int32_t x = b->x + 8 * m; // At least -7, so x + 8 is positive
+        const uint16_t bits = (uint16_t)(_ssd1309_reverse8(v) << ((x + 8) & 7));
+        const int32_t k = (x + 8) / 8 - 1;
+        if (k >= 0)
+            b->line[k] |= (uint8_t)bits;
+        if (k + 1 < (int32_t)sizeof(b->line))
+            b->line[k + 1] |= (uint8_t)(bits >> 8);
+    }
+}
+
+/**
+ * @brief Decode RLE8 or RLE4 data (bpp 8 or 4), rows without data are empty
+ */
+static void _ssd1309_bmp_decode_rle(_ssd1309_bmp_t *b, const uint8_t *data, size_t size, uint16_t bpp)
+{
+    int32_t r = 0, c = 0;
+    size_t i = 0;
+
+    while (r < b->height && i + 1 < size)
+    {
+        const uint8_t n = data[i++];
+        const uint8_t v = data[i++];
+
+        if (n > 0)
+        {
+            // n pixels of one index (RLE8) or of two alternating indices (RLE4)
+            for (uint8_t k = 0; k < n; ++k)
+                _ssd1309_bmp_pixel(b, c++, bpp == 8 ? v : (k & 1 ? v & 0x0F : v >> 4));
+        }
+        else if (v == 0) // End of line
+        {
+            _ssd1309_bmp_put(b, r++);
+            c = 0;
+        }
+        else if (v == 1) // End of bitmap
+        {
+            break;
+        }
+        else if (v == 2) // Delta, the skipped pixels are empty
+        {
+            if (i + 1 >= size)
+                break;
+            c += data[i++];
+            for (uint8_t dy = data[i++]; dy > 0 && r < b->height; --dy)
+                _ssd1309_bmp_put(b, r++);
+        }
+        else // Absolute run of v pixels, padded to 16 bits
+        {
+            const size_t bytes = bpp == 8 ? v : (v + 1) / 2;
+            if (i + bytes > size)
+                break;
+            for (uint8_t k = 0; k < v; ++k)
+                _ssd1309_bmp_pixel(b, c++, bpp == 8 ? data[i + k] : (data[i + k / 2] >> (k & 1 ? 0 : 4)) & 0x0F);
+            i += (bytes + 1) & ~(size_t)1;
+        }
+    }
+
+    while (r < b->height)
+        _ssd1309_bmp_put(b, r++);
+}
+
+/**
+ * @brief Draw a BMP image
+ *
+ * The header is validated against size once. 1, 4 and 8 bits per pixel are
+ * supported, uncompressed (top-down or bottom-up) or RLE8/RLE4 compressed.
+ * Pixels whose palette colour has a luminance below threshold are set, so
+ * dark pixels light up (128 for a black and white image). Rows are decoded
+ * into bits per display column and transposed into page bytes in 8x8
+ * blocks; only the visible part of the image is decoded where the format
+ * allows it.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] data : BMP file
+ * @param[in] size : size of data in bytes
+ * @param[in] x : x coordinate of top left corner
+ * @param[in] y : y coordinate of top left corner
+ * @param[in] blend : how the image is combined with the buffer
+ * @param[in] threshold : luminance (0 to 255) below which a colour is drawn
+ *
+ * @return false if the file is malformed or its format is not supported
+ */
+bool ssd1309_bmp_draw(ssd1309_t *p, const uint8_t *data, size_t size, int32_t x, int32_t y, ssd1309_blend_t blend, uint8_t threshold)
+{
+    if (data == NULL || size < 54 || data[0] != 'B' || data[1] != 'M')
+        return false;
+
+    const uint32_t bf_off_bits = _ssd1309_bmp_get_val(data, 10, 4);
+    const uint32_t bi_size = _ssd1309_bmp_get_val(data, 14, 4);
+    const int32_t bi_width = (int32_t)_ssd1309_bmp_get_val(data, 18, 4);
+    const int32_t bi_height = (int32_t)_ssd1309_bmp_get_val(data, 22, 4);
+    const uint16_t bi_bit_count = (uint16_t)_ssd1309_bmp_get_val(data, 28, 2);
+    const uint32_t bi_compression = _ssd1309_bmp_get_val(data, 30, 4);
+    const uint32_t bi_clr_used = _ssd1309_bmp_get_val(data, 46, 4);
+
+    if (bi_size < 40 || bi_size > size - 14 || bf_off_bits >= size)
+        return false;
+    if (bi_width <= 0 || bi_width > INT16_MAX || bi_height == 0 || bi_height > INT16_MAX || bi_height < -INT16_MAX)
+        return false;
+    if (bi_bit_count != 1 && bi_bit_count != 4 && bi_bit_count != 8)
+        return false;
+    if (bi_compression != 0 && !(bi_compression == 1 && bi_bit_count == 8) && !(bi_compression == 2 && bi_bit_count == 4))
+        return false;
+
+    const uint32_t colors = bi_clr_used != 0 && bi_clr_used < (1u << bi_bit_count) ? bi_clr_used : 1u << bi_bit_count;
+    const size_t table = 14 + bi_size;
+    if (table + colors * 4 > size)
+        return false;
+
+    const uint32_t stride = ((uint32_t)bi_width * bi_bit_count + 31) / 32 * 4;
+    const int32_t rows = bi_height < 0 ? -bi_height : bi_height;
+    if (bi_compression == 0 && (uint64_t)stride * rows > size - bf_off_bits)
+        return false;
+
+    _ssd1309_bmp_t b = {
+        .p = p,
+        .blend = blend,
+        .x = x,
+        .y = y,
+        .height = rows,
+        .top_down = bi_height < 0,
+        .vx0 = x > p->clip_x0 ? x : p->clip_x0,
+        .vx1 = (int64_t)x + bi_width - 1 < p->clip_x1 ? x + bi_width - 1 : p->clip_x1,
+        .vy0 = y > p->clip_y0 ? y : p->clip_y0,
+        .vy1 = (int64_t)y + rows - 1 < p->clip_y1 ? y + rows - 1 : p->clip_y1,
+        .page = -1,
+    };
+    if (b.vx0 > b.vx1 || b.vy0 > b.vy1)
+        return true;
+
+    for (int32_t c = b.vx0; c <= b.vx1; ++c)
+        b.columns[c / 8] |= 1 << (c & 7);
+
+    for (uint32_t i = 0; i < colors; ++i)
+    {
+        // Palette entries are stored as blue, green, red, reserved
+        const uint8_t *bgr = data + table + i * 4;
+        if ((bgr[2] * 77 + bgr[1] * 150 + bgr[0] * 29) >> 8 < threshold)
+            b.lit[i / 8] |= 1 << (i & 7);
+    }
+
+    if (bi_compression == 0)
+    {
+        // Rows are addressed directly, so only the visible ones are decoded
+        for (int32_t row = b.vy0; row <= b.vy1; ++row)
+        {
+            const int32_t r = b.top_down ? row - y : rows - 1 - (row - y);
+            _ssd1309_bmp_decode_row(&b, data + bf_off_bits + (size_t)r * stride, bi_bit_count);
+            _ssd1309_bmp_put(&b, r);
+        }
+    }
+    else
+        _ssd1309_bmp_decode_rle(&b, data + bf_off_bits, size - bf_off_bits, bi_bit_count);
+
+    _ssd1309_bmp_flush(&b);
+    return true;
+}
+
+/**
+ * @brief Draw a BMP image at an offset, see ssd1309_bmp_draw()
+ *
+ * Dark pixels are drawn on top of the buffer (SSD1309_BLEND_OR, threshold 128).
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] data : BMP file
+ * @param[in] size : size of data in bytes
+ * @param[in] x_offset : x coordinate of top left corner
+ * @param[in] y_offset : y coordinate of top left corner
+ *
+ */
+void ssd1309_bmp_show_image_with_offset(ssd1309_t *p, const uint8_t *data, const long size, uint32_t x_offset,
+                                        uint32_t y_offset)
+{
+    if (size > 0)
+        ssd1309_bmp_draw(p, data, (size_t)size, (int32_t)x_offset, (int32_t)y_offset, SSD1309_BLEND_OR, 128);
+}
+
+/**
+ * @brief Draw a BMP image at the top left corner, see ssd1309_bmp_show_image_with_offset()
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] data : BMP file
+ * @param[in] size : size of data in bytes
+ *
+ */
+void ssd1309_bmp_show_image(ssd1309_t *p, const uint8_t *data, const long size)
+{
+    ssd1309_bmp_show_image_with_offset(p, data, size, 0, 0);
+}
+
+/**
+ * @brief Rotate the columns x0 to x1 (GDDRAM columns) of one page of the buffer
+ *
+ * Columns of the GDDRAM that are not part of the buffer (panels narrower
+ * than 128 columns) are taken as blank.
+ */
+static void _ssd1309_scroll_columns(ssd1309_t *p, uint8_t *row, uint8_t x0, uint8_t x1, uint32_t steps, ssd1309_scroll_direction_t direction)
+{
+    const uint8_t len = x1 - x0 + 1;
+    uint8_t n = steps % len;
+    if (n == 0)
+        return;
+    if (direction == SSD1309_SCROLL_RIGHT)
+        n = len - n;
+
+    uint8_t ram[128] = {0};
+    memcpy(ram + p->column_offset, row, _SSD1309_WIDTH(p));
+
+    // Moving left by n is a left rotation of the range by n
+    uint8_t tmp[128];
+    memcpy(tmp, ram + x0, n);
+    memmove(ram + x0, ram + x0 + n, len - n);
+    memcpy(ram + x0 + len - n, tmp, n);
+
+    memcpy(row, ram + p->column_offset, _SSD1309_WIDTH(p));
+}
+
+/**
+ * @brief Rotate the rows of the vertical scroll area up by n rows
+ */
+static void _ssd1309_scroll_rows(ssd1309_t *p, uint8_t n)
+{
+    const uint8_t top = p->scroll.area_top;
+    const uint8_t rows = p->scroll.area_rows;
+    const uint64_t mask = _ssd1309_rows(top, top + rows - 1);
+
+    for (uint8_t x = 0; x < _SSD1309_WIDTH(p); ++x)
+    {
+        uint64_t column = 0;
+        for (uint8_t page = 0; page < _SSD1309_PAGES(p); ++page)
+            column |= (uint64_t)p->buffer[x + page * _SSD1309_WIDTH(p)] << (8 * page);
+
+        const uint64_t area = (column & mask) >> top;
+        column = (column & ~mask) | (((area >> n) | (area << (rows - n))) << top & mask);
+
+        for (uint8_t page = 0; page < _SSD1309_PAGES(p); ++page)
+            p->buffer[x + page * _SSD1309_WIDTH(p)] = (uint8_t)(column >> (8 * page));
+    }
+}
+
+static bool _ssd1309_scroll_range(ssd1309_t *p, uint8_t page0, uint8_t page1, uint8_t x0, uint8_t x1)
+{
+    return !p->transposed && page0 <= page1 && page1 < _SSD1309_PAGES(p) && x0 <= x1 && x1 < _SSD1309_WIDTH(p);
+}
+
+/**
+ * @brief Transmit pending damage and start the scroll engine with cmds
+ */
+static bool _ssd1309_scroll_start(ssd1309_t *p, uint8_t *cmds, size_t len, const ssd1309_scroll_t *scroll)
+{
+    if (p->scroll.active)
+        return false;
+
+    // The controller scrolls what it displays, so the buffer has to be shown first
+    ssd1309_show(p);
+    _ssd1309_write_commands(p, cmds, len);
+
+    p->scroll = *scroll;
+    p->scroll.active = true;
+    return true;
+}
+
+/**
+ * @brief Scroll pages continuously left or right
+ *
+ * The controller moves the columns x0 to x1 of pages page0 to page1 by one
+ * column per step and wraps them around, without any bus traffic. Pending
+ * damage is transmitted first. While scrolling, ssd1309_show(),
+ * ssd1309_show_async() and ssd1309_swap() keep the damage instead of
+ * writing to the display RAM, until ssd1309_scroll_stop() is called.
+ * Not available in the transposed orientations.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] direction : direction the content moves to
+ * @param[in] page0 : first page
+ * @param[in] page1 : last page
+ * @param[in] x0 : first column
+ * @param[in] x1 : last column
+ * @param[in] speed : frames per step
+ *
+ * @return false if the range is invalid or a scroll is already active
+ */
+bool ssd1309_scroll_horizontal(ssd1309_t *p, ssd1309_scroll_direction_t direction, uint8_t page0, uint8_t page1, uint8_t x0, uint8_t x1, ssd1309_scroll_speed_t speed)
+{
+    if (!_ssd1309_scroll_range(p, page0, page1, x0, x1) || (unsigned)speed > 7)
+        return false;
+
+    const ssd1309_scroll_t scroll = {
+        .horizontal = true,
+        .direction = direction,
+        .page0 = page0,
+        .page1 = page1,
+        .x0 = x0 + p->column_offset,
+        .x1 = x1 + p->column_offset,
+        .area_top = p->scroll.area_top,
+        .area_rows = p->scroll.area_rows,
+    };
+    uint8_t cmds[] = {
+        direction == SSD1309_SCROLL_LEFT ? SSD1309_contHScrollSetupLeft : SSD1309_contHScrollSetupRight,
+        0x00, // Dummy byte
+        page0,
+        speed,
+        page1,
+        scroll.x0,
+        scroll.x1,
+        SSD1309_activateScroll,
+    };
+
+    return _ssd1309_scroll_start(p, cmds, sizeof(cmds), &scroll);
+}
+
+/**
+ * @brief Scroll continuously up and left or right
+ *
+ * Every step moves the rows of the vertical scroll area (see
+ * ssd1309_set_scroll_area()) up by rows and pages page0 to page1 by one
+ * column, wrapping around the whole GDDRAM width. See
+ * ssd1309_scroll_horizontal() for how the buffer is handled while
+ * scrolling.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] direction : direction the content moves to
+ * @param[in] page0 : first page moved horizontally
+ * @param[in] page1 : last page moved horizontally
+ * @param[in] rows : rows moved up per step, less than the rows of the scroll area
+ * @param[in] speed : frames per step
+ *
+ * @return false if the range is invalid or a scroll is already active
+ */
+bool ssd1309_scroll_diagonal(ssd1309_t *p, ssd1309_scroll_direction_t direction, uint8_t page0, uint8_t page1, uint8_t rows, ssd1309_scroll_speed_t speed)
+{
+    if (!_ssd1309_scroll_range(p, page0, page1, 0, 0) || rows >= p->scroll.area_rows || (unsigned)speed > 7)
+        return false;
+
+    const ssd1309_scroll_t scroll = {
+        .horizontal = true,
+        .direction = direction,
+        .page0 = page0,
+        .page1 = page1,
+        .x0 = 0,
+        .x1 = 127,
+        .rows = rows,
+        .area_top = p->scroll.area_top,
+        .area_rows = p->scroll.area_rows,
+    };
+    uint8_t cmds[] = {
+        SSD1309_setVScrollArea,
+        (scroll.area_top - p->start_line) & 0x3F, // Rows of the fixed area, counted from the first COM line
+        scroll.area_rows,
+        direction == SSD1309_SCROLL_LEFT ? SSD1309_contVHScrollSetupLeft : SSD1309_contVHScrollSetupRight,
+        0x01, // Horizontal scroll on
+        page0,
+        speed,
+        page1,
+        rows,
+        SSD1309_activateScroll,
+    };
+
+    return _ssd1309_scroll_start(p, cmds, sizeof(cmds), &scroll);
+}
+
+/**
+ * @brief Scroll the vertical scroll area up continuously
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] rows : rows moved up per step, 1 to one less than the rows of the scroll area
+ * @param[in] speed : frames per step
+ *
+ * @return false if rows is invalid or a scroll is already active
+ */
+bool ssd1309_scroll_vertical(ssd1309_t *p, uint8_t rows, ssd1309_scroll_speed_t speed)
+{
+    if (p->transposed || rows == 0 || rows >= p->scroll.area_rows || (unsigned)speed > 7)
+        return false;
+
+    const ssd1309_scroll_t scroll = {
+        .rows = rows,
+        .area_top = p->scroll.area_top,
+        .area_rows = p->scroll.area_rows,
+    };
+    uint8_t cmds[] = {
+        SSD1309_setVScrollArea,
+        (scroll.area_top - p->start_line) & 0x3F, // Rows of the fixed area, counted from the first COM line
+        scroll.area_rows,
+        SSD1309_contVHScrollSetupRight,
+        0x00, // Horizontal scroll off
+        0,
+        speed,
+        _SSD1309_PAGES(p) - 1,
+        rows,
+        SSD1309_activateScroll,
+    };
+
+    return _ssd1309_scroll_start(p, cmds, sizeof(cmds), &scroll);
+}
+
+/**
+ * @brief Set the rows moved by vertical and diagonal scrolling
+ *
+ * Rows above and below the area stay in place. Defaults to the whole
+ * display.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] top : first row of the area
+ * @param[in] rows : number of rows of the area
+ *
+ * @return false if the area exceeds the display or a scroll is active
+ */
+bool ssd1309_set_scroll_area(ssd1309_t *p, uint8_t top, uint8_t rows)
+{
+    if (p->scroll.active || rows == 0 || top + rows > _SSD1309_HEIGHT(p))
+        return false;
+
+    p->scroll.area_top = top;
+    p->scroll.area_rows = rows;
+    return true;
+}
+
+/**
+ * @brief Move the content of pages left or right by one column
+ *
+ * The controller moves the columns x0 to x1 of pages page0 to page1 by one
+ * column, wrapping around, and the buffer (and shadow) are moved the same
+ * way, so nothing is transmitted. At least two frames have to pass between
+ * two content scrolls.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] direction : direction the content moves to
+ * @param[in] page0 : first page
+ * @param[in] page1 : last page
+ * @param[in] x0 : first column
+ * @param[in] x1 : last column
+ *
+ * @return false if the range is invalid or a continuous scroll is active
+ */
+bool ssd1309_scroll_content(ssd1309_t *p, ssd1309_scroll_direction_t direction, uint8_t page0, uint8_t page1, uint8_t x0, uint8_t x1)
+{
+    if (p->scroll.active || !_ssd1309_scroll_range(p, page0, page1, x0, x1))
+        return false;
+
+    uint8_t cmds[] = {
+        direction == SSD1309_SCROLL_LEFT ? SSD1309_contentScrollSetupLeft : SSD1309_contentScrollSetupRight,
+        0x00, // Dummy byte
+        page0,
+        0x01, // Dummy byte
+        page1,
+        x0 + p->column_offset,
+        x1 + p->column_offset,
+    };
+    _ssd1309_write_commands(p, cmds, sizeof(cmds));
+
+    for (uint8_t page = page0; page <= page1 && p->strips == 0; ++page)
+    {
+        _ssd1309_scroll_columns(p, p->buffer + page * _SSD1309_WIDTH(p), x0 + p->column_offset, x1 + p->column_offset, 1, direction);
+        if (p->shadow != NULL)
+            _ssd1309_scroll_columns(p, p->shadow + page * _SSD1309_WIDTH(p), x0 + p->column_offset, x1 + p->column_offset, 1, direction);
+
+        // Damage that was not transmitted yet moved along with the content
+        if (p->dirty.x0[page] <= p->dirty.x1[page])
+            _ssd1309_mark_dirty(p, page, x0, x1);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Stop hardware scrolling
+ *
+ * The controller's RAM content is undefined after scrolling, so the whole
+ * buffer is transmitted by the next ssd1309_show(). Passing the number of
+ * steps the controller performed (e.g. elapsed frames divided by the frames
+ * per step) applies the same movement to the buffer, so the image stays
+ * where it stopped; 0 returns it to the position it had when the scroll
+ * was started.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] steps : scroll steps performed by the controller
+ *
+ */
+void ssd1309_scroll_stop(ssd1309_t *p, uint32_t steps)
+{
+    if (!p->scroll.active)
+        return;
+
+    uint8_t cmds[] = {
+        SSD1309_deactivateScroll,
+        SSD1309_setDisplayStartLine | p->start_line,
+    };
+    _ssd1309_write_commands(p, cmds, sizeof(cmds));
+    p->scroll.active = false;
+
+    // Without a frame buffer the image is redrawn by the next ssd1309_render()
+    if (p->strips != 0)
+        return;
+
+    if (p->scroll.horizontal)
+        for (uint8_t page = p->scroll.page0; page <= p->scroll.page1; ++page)
+            _ssd1309_scroll_columns(p, p->buffer + page * _SSD1309_WIDTH(p), p->scroll.x0, p->scroll.x1, steps, p->scroll.direction);
+
+    if (p->scroll.rows != 0)
+    {
+        const uint8_t n = (uint64_t)steps * p->scroll.rows % p->scroll.area_rows;
+        if (n != 0)
+            _ssd1309_scroll_rows(p, n);
+    }
+
+    p->shadow_valid = false;
+    ssd1309_invalidate(p);
+}
+
+/**
+ * @brief Render a line of text into one page (width bytes), clipped to the page
+ */
+static void _ssd1309_terminal_render(const ssd1309_terminal_t *t, uint32_t line, uint8_t *page)
+{
+    const uint8_t width = _SSD1309_WIDTH(t->p);
+    memset(page, 0, width);
+    if (line >= t->total || line < t->total - t->count)
+        return;
+
+    const char *s = t->lines + (line % t->capacity) * t->columns;
+    const GFXfont *font = t->font;
+    int32_t x = 0;
+    for (uint8_t i = 0; i < t->columns && s[i] != '\0' && x < width; ++i)
+    {
+        if (s[i] < font->first || s[i] > font->last)
+            continue;
+
+        const GFXglyph *glyph = &font->glyph[(uint8_t)s[i] - font->first];
+        const int32_t top = t->baseline + glyph->yOffset;
+        const uint8_t r0 = top < 0 ? (uint8_t)(-top) : 0;
+        if (glyph->width > 0 && r0 < glyph->height && top + r0 < 8)
+        {
+            const uint8_t rows = glyph->height - r0 < 32 ? glyph->height - r0 : 32;
+            const uint8_t n = glyph->width < 32 ? glyph->width : 32;
+            uint32_t cols[32];
+            _ssd1309_glyph_columns(font->bitmap + glyph->bitmapOffset, glyph->width, r0, rows, 0, n, cols);
+
+            for (uint8_t c = 0; c < n; ++c)
+            {
+                const int32_t cx = x + glyph->xOffset + c;
+                if (cx >= 0 && cx < width)
+                    page[cx] |= (uint8_t)(cols[c] << (top + r0));
+            }
+        }
+        x += glyph->xAdvance;
+    }
+}
+
+/**
+ * @brief Transmit line to the GDDRAM page shown in row of the terminal
+ */
+static void _ssd1309_terminal_show_line(const ssd1309_terminal_t *t, uint32_t line, uint8_t row)
+{
+    uint8_t page[128];
+    const uint8_t gddram_page = (t->top_page + row) % SSD1309_MAX_PAGES;
+
+    _ssd1309_terminal_render(t, line, page);
+    _ssd1309_set_window(t->p, 0, _SSD1309_WIDTH(t->p) - 1, gddram_page, gddram_page);
+    _ssd1309_write_data(t->p, page, _SSD1309_WIDTH(t->p));
+}
+
+/**
+ * @brief Bring the display to the lines selected by view
+ *
+ * Lines that stay on the display are moved by the start line, only the
+ * lines that become visible are transmitted.
+ */
+static void _ssd1309_terminal_update(ssd1309_terminal_t *t)
+{
+    const uint32_t oldest = t->total - t->count;
+    const uint32_t bottom = t->total - 1 - t->view;
+    const uint32_t top = bottom >= oldest + t->rows - 1 ? bottom - (t->rows - 1) : oldest;
+    const int64_t delta = (int64_t)top - t->top_line;
+    if (delta == 0)
+        return;
+
+    uint8_t row0 = 0, row1 = t->rows;
+    if (delta > -t->rows && delta < t->rows)
+    {
+        t->top_page = (uint8_t)((t->top_page + delta) & (SSD1309_MAX_PAGES - 1));
+        if (delta > 0)
+            row0 = t->rows - (uint8_t)delta;
+        else
+            row1 = (uint8_t)-delta;
+    }
+    t->top_line = top;
+
+    // Lines are written before they are scrolled in, so no stale content shows up
+    for (uint8_t row = row0; row < row1; ++row)
+        _ssd1309_terminal_show_line(t, top + row, row);
+    _ssd1309_write_command(t->p, SSD1309_setDisplayStartLine | ((t->p->start_line + 8 * t->top_page) & 0x3F));
+}
+
+static void _ssd1309_terminal_newline(ssd1309_terminal_t *t)
+{
+    ssd1309_terminal_flush(t);
+
+    memset(t->lines + (t->total % t->capacity) * t->columns, 0, t->columns);
+    ++(t->total);
+    if (t->count < t->capacity)
+        ++(t->count);
+    t->cursor = 0;
+
+    _ssd1309_terminal_update(t);
+}
+
+/**
+ * @brief Start a terminal that scrolls with the display start line
+ *
+ * Every line of text occupies one page. New lines are written to the page
+ * that was scrolled out and the display start line is advanced, so a line
+ * feed costs one command and one page of data. Past lines are kept in
+ * history (the size / columns most recent lines, where columns is the
+ * width of the display divided by the advance of ' ') and can be viewed
+ * with ssd1309_terminal_scroll().
+ *
+ * The terminal writes to the display RAM directly: the frame buffer is
+ * neither used nor changed, and neither ssd1309_show() nor
+ * ssd1309_set_orientation() may be called until ssd1309_terminal_end().
+ * Not available in the transposed orientations or while a hardware
+ * scroll runs.
+ *
+ * @param[in,out] t : terminal
+ * @param[in,out] p : instance of display
+ * @param[in] font : font of the text, glyphs higher than 8 rows are clipped
+ * @param[in] history : storage of the history
+ * @param[in] size : size of history in bytes
+ *
+ * @return false if history cannot hold the lines of a full display
+ */
+bool ssd1309_terminal_init(ssd1309_terminal_t *t, ssd1309_t *p, const GFXfont *font, char *history, size_t size)
+{
+    const uint32_t advance = _ssd1309_advance(font, ' ');
+    if (p->transposed || p->scroll.active || advance == 0)
+        return false;
+
+    const uint32_t columns = _SSD1309_WIDTH(p) / advance;
+    if (columns == 0)
+        return false;
+
+    t->p = p;
+    t->font = font;
+    t->lines = history;
+    t->columns = columns > UINT8_MAX ? UINT8_MAX : (uint8_t)columns;
+    t->capacity = size / t->columns > UINT16_MAX ? UINT16_MAX : (uint16_t)(size / t->columns);
+    t->rows = _SSD1309_PAGES(p);
+    if (t->capacity < t->rows)
+        return false;
+
+    // Align the tallest glyph with the top of the page
+    _ssd1309_gfx_cell_rows(p, font);
+    t->baseline = -p->cell_top;
+
+    t->cursor = 0;
+    t->line_dirty = false;
+    t->top_page = 0;
+    t->total = 1;
+    t->count = 1;
+    t->view = 0;
+    t->top_line = 0;
+    memset(history, 0, t->columns);
+
+    for (uint8_t row = 0; row < t->rows; ++row)
+        _ssd1309_terminal_show_line(t, row, row);
+    _ssd1309_write_command(p, SSD1309_setDisplayStartLine | p->start_line);
+
+    return true;
+}
+
+/**
+ * @brief Write a character to a terminal
+ *
+ * '\n' starts a new line, '\r' returns to the start of the line, lines
+ * longer than the display wrap. Output scrolls the view back to the newest
+ * line. The current line is only transmitted on '\n' or by
+ * ssd1309_terminal_flush(). Has the signature of the output callback of
+ * callback-based formatters, see ssd1309_text_putc().
+ *
+ * @param[in] c : character
+ * @param[in,out] terminal : terminal (ssd1309_terminal_t)
+ *
+ */
+void ssd1309_terminal_putc(char c, void *terminal)
+{
+    ssd1309_terminal_t *t = (ssd1309_terminal_t *)terminal;
+
+    if (t->view != 0)
+    {
+        t->view = 0;
+        _ssd1309_terminal_update(t);
+    }
+
+    if (c == '\n')
+    {
+        _ssd1309_terminal_newline(t);
+        return;
+    }
+    if (c == '\r')
+    {
+        t->cursor = 0;
+        return;
+    }
+    if (c < t->font->first || c > t->font->last)
+        return;
+
+    if (t->cursor == t->columns)
+        _ssd1309_terminal_newline(t);
+
+    t->lines[((t->total - 1) % t->capacity) * t->columns + t->cursor++] = c;
+    t->line_dirty = true;
+}
+
+/**
+ * @brief Write a string to a terminal and transmit the current line
+ *
+ * @param[in,out] t : terminal
+ * @param[in] s : string
+ *
+ */
+void ssd1309_terminal_puts(ssd1309_terminal_t *t, const char *s)
+{
+    for (; *s; ++s)
+        ssd1309_terminal_putc(*s, t);
+    ssd1309_terminal_flush(t);
+}
+
+/**
+ * @brief Transmit the current line if it changed
+ *
+ * @param[in,out] t : terminal
+ *
+ */
+void ssd1309_terminal_flush(ssd1309_terminal_t *t)
+{
+    if (!t->line_dirty)
+        return;
+
+    t->line_dirty = false;
+    const uint32_t line = t->total - 1;
+    if (line >= t->top_line && line < t->top_line + t->rows)
+        _ssd1309_terminal_show_line(t, line, (uint8_t)(line - t->top_line));
+}
+
+/**
+ * @brief Scroll through the history of a terminal
+ *
+ * Only the lines scrolled in are transmitted (unless the view moves by a
+ * whole display or more).
+ *
+ * @param[in,out] t : terminal
+ * @param[in] lines : lines to scroll back (positive) or forward (negative)
+ *
+ */
+void ssd1309_terminal_scroll(ssd1309_terminal_t *t, int32_t lines)
+{
+    const int32_t max = t->count > t->rows ? t->count - t->rows : 0;
+    int64_t view = (int64_t)t->view + lines;
+    if (view < 0)
+        view = 0;
+    if (view > max)
+        view = max;
+
+    t->view = (uint16_t)view;
+    _ssd1309_terminal_update(t);
+}
+
+/**
+ * @brief Stop a terminal and return the display to the frame buffer
+ *
+ * The start line is restored and the whole buffer is transmitted by the
+ * next ssd1309_show().
+ *
+ * @param[in,out] t : terminal
+ *
+ */
+void ssd1309_terminal_end(ssd1309_terminal_t *t)
+{
+    ssd1309_t *p = t->p;
+
+    _ssd1309_write_command(p, SSD1309_setDisplayStartLine | p->start_line);
+    p->shadow_valid = false;
+    ssd1309_invalidate(p);
+}
+
+/**
+ * @brief Enable diffing against a shadow copy of the controller's GDDRAM
+ *
+ * With a shadow, ssd1309_show() only transmits bytes that differ from what
+ * the controller already displays, so redrawing an unchanged frame costs no
+ * bus traffic. The first show after enabling transmits the full buffer.
+ *
  * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of top left corner
- * @param[in] y : y coordinate of top left corner
- * @param[in] scale : scale of char
- * @param[in] s : string to draw
+ * @param[in] shadow : buffer of p->bufsize bytes, or NULL to allocate one
+ *
+ * @return bool.
+ * @retval true for Success
+ * @retval false if the shadow could not be allocated or the display has no frame buffer
  *
  */
-void ssd1309_draw_string(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *s)
+bool ssd1309_shadow_enable(ssd1309_t *p, uint8_t *shadow)
 {
-    ssd1309_draw_string_with_font(p, x, y, scale, SSD1309_DEFAULT_FONT, s);
+    ssd1309_shadow_disable(p);
+    if (p->strips != 0)
+        return false;
+
+    p->shadow_owned = shadow == NULL;
+    if (shadow == NULL && (shadow = (uint8_t *)malloc(p->bufsize)) == NULL)
+    {
+        p->shadow_owned = false;
+        return false;
+    }
+
+    p->shadow = shadow;
+    ssd1309_invalidate(p);
+
+    return true;
 }
 
-vector2_t ssd1309_get_string_size_with_font(const GFXfont font, const char *s)
+/**
+ * @brief Disable shadow diffing and release a driver-allocated shadow
+ *
+ * @param[in,out] p : instance of display
+ *
+ */
+void ssd1309_shadow_disable(ssd1309_t *p)
 {
-    vector2_t size = {0, 0};
-    for (; *s; s++)
+    if (p->shadow_owned)
+        free(p->shadow);
+
+    p->shadow = NULL;
+    p->shadow_owned = false;
+    p->shadow_valid = false;
+}
+
+static bool _ssd1309_plan_window(ssd1309_window_t *windows, uint8_t *count, uint32_t *cost, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1, bool full_width)
+{
+    if (*count == SSD1309_MAX_WINDOWS)
+        return false;
+
+    windows[*count] = (ssd1309_window_t){x0, x1, page0, page1};
+    ++(*count);
+
+    // Windows that do not span the full width need one data transfer per page
+    *cost += SSD1309_WINDOW_COST + (uint32_t)(x1 - x0 + 1) * (page1 - page0 + 1);
+    if (!full_width)
+        *cost += (page1 - page0) * SSD1309_TRANSACTION_COST;
+
+    return true;
+}
+
+static bool _ssd1309_plan_diff(ssd1309_t *p, const uint8_t *frame, const ssd1309_damage_t *damage, uint8_t page, ssd1309_window_t *windows, uint8_t *count, uint32_t *cost)
+{
+    const uint8_t *buf = frame + page * _SSD1309_WIDTH(p);
+    const uint8_t *shadow = p->shadow + page * _SSD1309_WIDTH(p);
+    int16_t run0 = -1;
+    int16_t run1 = -1;
+
+    for (int16_t x = damage->x0[page]; x <= damage->x1[page]; ++x)
     {
-        const GFXglyph glyph = font.glyph[(uint8_t)*s];
-        size.width += glyph.xAdvance;
-        size.height = font.yAdvance;
+        if (buf[x] == shadow[x])
+            continue;
+
+        // A gap cheaper to resend than to open a new window is merged into the run
+        if (run0 >= 0 && x - run1 - 1 > SSD1309_WINDOW_COST)
+        {
+            if (!_ssd1309_plan_window(windows, count, cost, run0, run1, page, page, false))
+                return false;
+            run0 = -1;
+        }
+
+        if (run0 < 0)
+            run0 = x;
+        run1 = x;
     }
-    return size;
+
+    if (run0 >= 0)
+        return _ssd1309_plan_window(windows, count, cost, run0, run1, page, page, false);
+
+    return true;
 }
 
-vector2_t ssd1309_get_string_size(const char *s)
+static uint8_t _ssd1309_plan(ssd1309_t *p, const uint8_t *frame, const ssd1309_damage_t *damage)
 {
-    return ssd1309_get_string_size_with_font(SSD1309_DEFAULT_FONT, s);
+    uint8_t count = 0;
+    uint32_t cost = 0;
+    bool fits = true;
+    const bool diff = p->shadow != NULL && p->shadow_valid;
+    ssd1309_window_t *windows = p->windows;
+
+    for (uint8_t page = 0; fits && page < _SSD1309_PAGES(p); ++page)
+    {
+        const uint8_t x0 = damage->x0[page];
+        const uint8_t x1 = damage->x1[page];
+        if (x0 > x1)
+            continue;
+
+        if (diff)
+        {
+            fits = _ssd1309_plan_diff(p, frame, damage, page, windows, &count, &cost);
+            continue;
+        }
+
+        uint8_t last = page;
+        while (last + 1 < _SSD1309_PAGES(p) && damage->x0[last + 1] == x0 && damage->x1[last + 1] == x1)
+            ++last;
+
+        fits = _ssd1309_plan_window(windows, &count, &cost, x0, x1, page, last, x0 == 0 && x1 == _SSD1309_WIDTH(p) - 1);
+        page = last;
+    }
+
+    // Fall back to a single full transfer when that is cheaper than the windows
+    if (!fits || (count > 1 && cost >= SSD1309_WINDOW_COST + p->bufsize))
+    {
+        windows[0] = (ssd1309_window_t){0, _SSD1309_WIDTH(p) - 1, 0, _SSD1309_PAGES(p) - 1};
+        count = 1;
+    }
+
+    return count;
+}
+
+static void _ssd1309_prepare(ssd1309_t *p, uint8_t *frame, ssd1309_damage_t *damage)
+{
+    p->window_count = _ssd1309_plan(p, frame, damage);
+    p->window_index = 0;
+    p->tx_buffer = frame;
+    p->tx_page = 0;
+
+    // The shadow is brought up to date before the transfer, so the frame is
+    // sent from it and the buffer may be drawn to while the transfer runs
+    if (p->shadow != NULL)
+    {
+        for (uint8_t page = 0; page < _SSD1309_PAGES(p); ++page)
+        {
+            const uint8_t x0 = p->shadow_valid ? damage->x0[page] : 0;
+            const uint8_t x1 = p->shadow_valid ? damage->x1[page] : _SSD1309_WIDTH(p) - 1;
+            if (x0 <= x1)
+                memcpy(p->shadow + x0 + page * _SSD1309_WIDTH(p), frame + x0 + page * _SSD1309_WIDTH(p), x1 - x0 + 1);
+        }
+        p->shadow_valid = true;
+        p->tx_buffer = p->shadow;
+    }
+
+    _ssd1309_damage_clear(damage);
+}
+
+inline static bool _ssd1309_window_full_width(ssd1309_t *p, const ssd1309_window_t *w)
+{
+    return w->x0 == 0 && w->x1 == _SSD1309_WIDTH(p) - 1;
 }
 
 /**
- * @brief Draw formatted string using default font
+ * @brief Transmit damaged parts of the display buffer
+ *
+ * Only the column span of each page touched since the last call is sent.
+ * Consecutive pages damaged over the same columns share one address window.
+ * If a shadow is enabled, the damaged spans are diffed against it and only
+ * the changed runs are sent. Runs are merged while resending the gap is
+ * cheaper than opening another window, and a full transfer is used when
+ * the windows would cost more than that.
  *
  * @param[in,out] p : instance of display
- * @param[in] x : x coordinate of top left corner
- * @param[in] y : y coordinate of top left corner
- * @param[in] scale : scale of char
- * @param[in] format : format string
- * @param[in] ... : arguments
  *
  */
-void ssd1309_printf(ssd1309_t *disp, uint32_t x, uint32_t y, uint32_t scale, const char *format, ...)
+void ssd1309_show(ssd1309_t *p)
 {
-    char buf[128];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buf, sizeof(buf), format, args);
-    va_end(args);
+    if (p->scroll.active || p->strips != 0)
+        return;
+
+    _ssd1309_drain(p);
+    _ssd1309_prepare(p, p->buffer, &p->dirty);
+
+    for (uint8_t i = 0; i < p->window_count; ++i)
+    {
+        const ssd1309_window_t *w = &p->windows[i];
+        _ssd1309_set_window(p, w->x0, w->x1, w->page0, w->page1);
 
-    uint32_t y_offset = y * SSD1309_DEFAULT_FONT.yAdvance * scale;
-    uint32_t x_offset = x * 6 * scale;
+        if (_ssd1309_window_full_width(p, w))
+        {
+            _ssd1309_write_data(p, p->tx_buffer + w->page0 * _SSD1309_WIDTH(p), (w->page1 - w->page0 + 1) * _SSD1309_WIDTH(p));
+        }
+        else
+        {
+            for (uint8_t page = w->page0; page <= w->page1; ++page)
+                _ssd1309_write_data(p, p->tx_buffer + w->x0 + page * _SSD1309_WIDTH(p), w->x1 - w->x0 + 1);
+        }
+    }
 
-    ssd1309_draw_string(disp, x_offset, y_offset, scale, buf);
+    p->window_count = 0;
 }
 
-void _ssd1309_get_char_position_size(uint32_t *x, uint32_t *y, uint32_t *width, uint32_t *height, uint32_t scale)
+/**
+ * @brief Set the transport used by ssd1309_show_async()
+ *
+ * The callback only starts a transfer (e.g. queues a DMA transaction) and
+ * returns. Once the transfer finished, the application calls
+ * ssd1309_transfer_complete(), typically from the completion interrupt.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] spi_async_cb : callback starting a transfer, NULL to disable
+ *
+ */
+void ssd1309_set_async(ssd1309_t *p, ssd1309_spi_async_callback_t spi_async_cb)
 {
-    *x = 6 * scale * (*x);
-    *y = 8 * scale * (*y);
-    *width = 6 * scale;
-    *height = 8 * scale;
+    _ssd1309_drain(p);
+    p->spi_async_cb = spi_async_cb;
 }
 
-void ssd1309_cursor(ssd1309_t *disp, uint32_t x, uint32_t y, uint32_t scale, enum cursor_type type)
+static bool _ssd1309_start_transfer(ssd1309_t *p, bool data, uint8_t *buf, size_t len)
 {
-    uint32_t width = 0;
-    uint32_t height = 0;
-    _ssd1309_get_char_position_size(&x, &y, &width, &height, scale);
+    p->transfer_done = false;
+    p->pin_cb(SSD1309_PIN_DC, data);
+    p->pin_cb(SSD1309_PIN_CS, false);
 
-    switch (type)
+    if (p->spi_async_cb(buf, len))
+        return true;
+
+    // Abort the frame, the damage is retransmitted by the next show
+    p->pin_cb(SSD1309_PIN_CS, true);
+    p->state = SSD1309_STATE_IDLE;
+    p->front = SSD1309_NO_BUFFER;
+    p->shadow_valid = false;
+    ssd1309_invalidate(p);
+
+    return false;
+}
+
+static bool _ssd1309_start_window(ssd1309_t *p)
+{
+    const ssd1309_window_t *w = &p->windows[p->window_index];
+
+    p->window_cmds[0] = SSD1309_setColumnAddress;
+    p->window_cmds[1] = w->x0 + p->column_offset;
+    p->window_cmds[2] = w->x1 + p->column_offset;
+    p->window_cmds[3] = SSD1309_setPageAddress;
+    p->window_cmds[4] = w->page0;
+    p->window_cmds[5] = w->page1;
+
+    p->state = SSD1309_STATE_COMMAND;
+    return _ssd1309_start_transfer(p, false, p->window_cmds, sizeof(p->window_cmds));
+}
+
+static bool _ssd1309_start_data(ssd1309_t *p)
+{
+    const ssd1309_window_t *w = &p->windows[p->window_index];
+
+    p->state = SSD1309_STATE_DATA;
+    if (_ssd1309_window_full_width(p, w))
     {
-    case CURSOR_NONE:
-        break;
-    case CURSOR_UNDERSCORE:
-        ssd1309_draw_line(disp, x, y + height - 1, x + width - 2, y + height - 1);
-        break;
-    case CURSOR_BLOCK:
-        ssd1309_invert_square(disp, x - 1, y - 1, width + 1, height + 1);
-        break;
-    default:
-        break;
+        p->window_page = w->page1;
+        return _ssd1309_start_transfer(p, true, p->tx_buffer + (w->page0 - p->tx_page) * _SSD1309_WIDTH(p), (w->page1 - w->page0 + 1) * _SSD1309_WIDTH(p));
     }
+
+    return _ssd1309_start_transfer(p, true, p->tx_buffer + w->x0 + (p->window_page - p->tx_page) * _SSD1309_WIDTH(p), w->x1 - w->x0 + 1);
 }
 
-static inline uint32_t _ssd1309_bmp_get_val(const uint8_t *data, const size_t offset, uint8_t size)
+/**
+ * @brief Start transmitting damaged parts of the display buffer without blocking
+ *
+ * Plans the transfer like ssd1309_show() and starts it on the asynchronous
+ * transport. Progress is made by ssd1309_poll(). If a shadow is enabled, the
+ * frame is transmitted from it and drawing may continue immediately;
+ * otherwise the buffer must not be modified until ssd1309_poll() returns
+ * false.
+ *
+ * @param[in,out] p : instance of display
+ *
+ * @return bool.
+ * @retval true if the frame was started (or there was nothing to send)
+ * @retval false if a transfer is still in progress or could not be started
+ *
+ */
+bool ssd1309_show_async(ssd1309_t *p)
 {
-    switch (size)
+    if (p->spi_async_cb == NULL || p->state != SSD1309_STATE_IDLE)
+        return false;
+    if (p->scroll.active || p->strips != 0)
+        return true;
+
+    _ssd1309_prepare(p, p->buffer, &p->dirty);
+    if (p->window_count == 0)
+        return true;
+
+    return _ssd1309_start_window(p);
+}
+
+static bool _ssd1309_start_queued(ssd1309_t *p)
+{
+    if (p->queued == SSD1309_NO_BUFFER)
+        return false;
+
+    // Without a shadow the frame is sent from its buffer, which stays in flight
+    const uint8_t frame = p->queued;
+    p->queued = SSD1309_NO_BUFFER;
+    _ssd1309_prepare(p, p->buffers[frame], &p->queued_dirty);
+    p->front = p->shadow == NULL ? frame : SSD1309_NO_BUFFER;
+
+    if (p->window_count == 0)
     {
-    case 1:
-        return data[offset];
-    case 2:
-        return data[offset] | (data[offset + 1] << 8);
-    case 4:
-        return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (data[offset + 3] << 24);
-    default:
-        return 0;
+        p->front = SSD1309_NO_BUFFER;
+        return false;
     }
-    return 0;
+
+    return _ssd1309_start_window(p);
 }
 
-void ssd1309_bmp_show_image_with_offset(ssd1309_t *p, const uint8_t *data, const long size, uint32_t x_offset,
-                                        uint32_t y_offset)
+/**
+ * @brief Advance an asynchronous transfer
+ *
+ * Sequences the transfer once the previous phase completed: window commands
+ * with DC low, then the window data with DC high (one transfer per page for
+ * windows narrower than the display), then the next window. CS is released
+ * between phases, so DC only changes while CS is high. When a frame is
+ * finished, a frame queued by ssd1309_swap() is started.
+ *
+ * @param[in,out] p : instance of display
+ *
+ * @return bool.
+ * @retval true while the transfer is still in progress
+ * @retval false if the display is idle
+ *
+ */
+bool ssd1309_poll(ssd1309_t *p)
 {
-    if (size < 54) // data smaller than header
-        return;
+    if (p->state == SSD1309_STATE_IDLE)
+        return _ssd1309_start_queued(p);
 
-    const uint32_t bf_off_bits = _ssd1309_bmp_get_val(data, 10, 4);
-    const uint32_t bi_size = _ssd1309_bmp_get_val(data, 14, 4);
-    const int32_t bi_width = (int32_t)_ssd1309_bmp_get_val(data, 18, 4);
-    const int32_t bi_height = (int32_t)_ssd1309_bmp_get_val(data, 22, 4);
-    const uint16_t bi_bit_count = (uint16_t)_ssd1309_bmp_get_val(data, 28, 2);
-    const uint32_t bi_compression = _ssd1309_bmp_get_val(data, 30, 4);
+    if (!p->transfer_done)
+        return true;
 
-    if (bi_bit_count != 1) // image not monochrome
-        return;
+    p->pin_cb(SSD1309_PIN_CS, true);
 
-    if (bi_compression != 0) // image compressed
-        return;
+    const ssd1309_window_t *w = &p->windows[p->window_index];
+    if (p->state == SSD1309_STATE_COMMAND)
+    {
+        p->window_page = w->page0;
+        return _ssd1309_start_data(p);
+    }
+
+    if (p->window_page < w->page1)
+    {
+        ++(p->window_page);
+        return _ssd1309_start_data(p);
+    }
+
+    if (++(p->window_index) < p->window_count)
+        return _ssd1309_start_window(p);
+
+    p->state = SSD1309_STATE_IDLE;
+    p->window_count = 0;
+    p->front = SSD1309_NO_BUFFER;
+    return _ssd1309_start_queued(p);
+}
+
+/**
+ * @brief Signal completion of a transfer started by the asynchronous transport
+ *
+ * Safe to call from an interrupt; the next phase is started by ssd1309_poll().
+ *
+ * @param[in,out] p : instance of display
+ *
+ */
+void ssd1309_transfer_complete(ssd1309_t *p)
+{
+    p->transfer_done = true;
+}
 
-    const int table_start = 14 + bi_size;
-    uint8_t color_val = 0;
+/**
+ * @brief Set up double or triple buffering
+ *
+ * Adds up to two frame buffers to the one set up by ssd1309_init(). Drawing
+ * always targets p->buffer, which ssd1309_swap() exchanges for a buffer that
+ * is not being transmitted. Previously added buffers are released.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] extra : array of count buffers of p->bufsize bytes, NULL entries (or a NULL array) are allocated
+ * @param[in] count : number of additional buffers (0 for single buffering)
+ *
+ * @return bool.
+ * @retval true for Success
+ * @retval false if count is too large, a buffer could not be allocated or the display has no frame buffer
+ *
+ */
+bool ssd1309_set_buffers(ssd1309_t *p, uint8_t *const *extra, uint8_t count)
+{
+    _ssd1309_drain(p);
 
-    for (uint8_t i = 0; i < 2; ++i)
+    if (p->back != 0)
     {
-        if (!((data[table_start + i * 4] << 16) | (data[table_start + i * 4 + 1] << 8) | data[table_start + i * 4 + 2]))
-        {
-            color_val = i;
-            break;
-        }
+        memcpy(p->buffers[0], p->buffer, p->bufsize);
+        p->back = 0;
+        p->buffer = p->buffers[0];
     }
 
-    uint32_t bytes_per_line = (bi_width / 8) + (bi_width & 7 ? 1 : 0);
-    if (bytes_per_line & 3)
-        bytes_per_line = (bytes_per_line ^ (bytes_per_line & 3)) + 4;
+    for (uint8_t i = 1; i < p->buffer_count; ++i)
+        if (p->buffers_owned & (1 << i))
+            free(p->buffers[i]);
+    p->buffers_owned &= 1;
+    p->buffer_count = 1;
 
-    const uint8_t *img_data = data + bf_off_bits;
+    if (count > SSD1309_MAX_BUFFERS - 1 || (count != 0 && p->strips != 0))
+        return false;
 
-    int step = bi_height > 0 ? -1 : 1;
-    int border = bi_height > 0 ? -1 : bi_height;
-    for (uint32_t y = bi_height > 0 ? bi_height - 1 : 0; y != border; y += step)
+    for (uint8_t i = 0; i < count; ++i)
     {
-        for (uint32_t x = 0; x < bi_width; ++x)
+        uint8_t *buf = extra != NULL ? extra[i] : NULL;
+        if (buf == NULL)
         {
-            if (((img_data[x >> 3] >> (7 - (x & 7))) & 1) == color_val)
-                ssd1309_draw_pixel(p, x_offset + x, y_offset + y);
+            if ((buf = (uint8_t *)malloc(p->bufsize)) == NULL)
+            {
+                ssd1309_set_buffers(p, NULL, 0);
+                return false;
+            }
+            p->buffers_owned |= 1 << p->buffer_count;
         }
-        img_data += bytes_per_line;
+        p->buffers[p->buffer_count++] = buf;
     }
+
+    return true;
 }
 
-void ssd1309_bmp_show_image(ssd1309_t *p, const uint8_t *data, const long size)
+static uint8_t _ssd1309_free_buffer(ssd1309_t *p)
 {
-    ssd1309_bmp_show_image_with_offset(p, data, size, 0, 0);
+    for (uint8_t i = 0; i < p->buffer_count; ++i)
+        if (i != p->back && i != p->front && i != p->queued)
+            return i;
+
+    return SSD1309_NO_BUFFER;
 }
 
-void ssd1309_show(ssd1309_t *p)
+/**
+ * @brief Hand the back buffer to the transport and continue on another buffer
+ *
+ * The finished frame is queued and started as soon as the transport is idle;
+ * with triple buffering, a frame still waiting in the queue is replaced by the
+ * newer one. The new back buffer starts out as a copy of the queued frame, so
+ * partial redraws keep working. Blocks only if every other buffer is in use.
+ * Without an asynchronous transport or additional buffers, this is the same
+ * as ssd1309_show().
+ *
+ * @param[in,out] p : instance of display
+ *
+ */
+void ssd1309_swap(ssd1309_t *p)
+{
+    if (p->scroll.active)
+        return;
+
+    if (p->spi_async_cb == NULL || p->buffer_count == 1)
+    {
+        ssd1309_show(p);
+        return;
+    }
+
+    const uint8_t frame = p->back;
+    _ssd1309_damage_merge(&p->queued_dirty, &p->dirty);
+    _ssd1309_damage_clear(&p->dirty);
+    p->queued = frame;
+
+    uint8_t next;
+    while ((next = _ssd1309_free_buffer(p)) == SSD1309_NO_BUFFER)
+        ssd1309_poll(p);
+
+    memcpy(p->buffers[next], p->buffers[frame], p->bufsize);
+    p->back = next;
+    p->buffer = p->buffers[next];
+
+    if (p->state == SSD1309_STATE_IDLE)
+        _ssd1309_start_queued(p);
+}
+
+/**
+ * @brief Draw and transmit a frame with a draw callback
+ *
+ * In strip mode (see ssd1309_init_strips()), draw is called once per page
+ * with a blank strip, the clip rectangle limited to that page and the font
+ * and text mode as they were on entry, so it has to draw the same frame
+ * every time. Each page is transmitted as soon as it is drawn. With two
+ * strips and an asynchronous transport, the next page is drawn while the
+ * previous one is transmitted, and the last page is completed by
+ * ssd1309_poll(). With a frame buffer, the buffer is cleared, drawn once
+ * and shown.
+ *
+ * @param[in,out] p : instance of display
+ * @param[in] draw : callback drawing the frame, NULL for a blank frame
+ * @param[in] ctx : passed to draw
+ *
+ */
+void ssd1309_render(ssd1309_t *p, ssd1309_draw_callback_t draw, void *ctx)
 {
-    _ssd1309_write_command(p, SSD1309_setColumnAddress);
-    _ssd1309_write_command(p, 0);            // Column start address (0 = reset)
-    _ssd1309_write_command(p, p->width - 1); // Column end address (127 = reset)
+    if (p->strips == 0)
+    {
+        ssd1309_clear(p);
+        if (draw != NULL)
+            draw(p, ctx);
+        ssd1309_show(p);
+        return;
+    }
+
+    if (p->scroll.active)
+        return;
 
-    _ssd1309_write_command(p, SSD1309_setPageAddress);
-    _ssd1309_write_command(p, 0);            // Page start address (0 = reset)
-    _ssd1309_write_command(p, p->pages - 1); // Page end address
+    const GFXfont *font = p->font;
+    const ssd1309_text_mode_t mode = p->text_mode;
+    const bool pipelined = p->spi_async_cb != NULL && p->strips == 2;
 
-    _ssd1309_write_data(p, p->buffer, p->bufsize);
-}
\ No newline at end of file
+    _ssd1309_drain(p);
+    for (uint8_t page = 0; page < _SSD1309_PAGES(p); ++page)
+    {
+        p->buffer = p->buffers[0] + (page % p->strips) * _SSD1309_WIDTH(p);
+        p->buffer_page = page;
+        memset(p->buffer, 0, p->bufsize);
+        ssd1309_reset_clip(p);
+        p->font = font;
+        p->text_mode = mode;
+        if (draw != NULL)
+            draw(p, ctx);
+
+        if (!pipelined)
+        {
+            _ssd1309_set_window(p, 0, _SSD1309_WIDTH(p) - 1, page, page);
+            _ssd1309_write_data(p, p->buffer, _SSD1309_WIDTH(p));
+            continue;
+        }
+
+        // Wait for the previous page, so its strip can be drawn to next
+        _ssd1309_drain(p);
+        p->windows[0] = (ssd1309_window_t){0, _SSD1309_WIDTH(p) - 1, page, page};
+        p->window_count = 1;
+        p->window_index = 0;
+        p->tx_buffer = p->buffer;
+        p->tx_page = page;
+        _ssd1309_start_window(p);
+    }
+
+    p->buffer = p->buffers[0];
+    p->buffer_page = SSD1309_NO_BUFFER;
+    ssd1309_reset_clip(p);
+    p->font = font;
+    p->text_mode = mode;
+    _ssd1309_damage_clear(&p->dirty);
+}
@@ -37,6 +37,7 @@ SOFTWARE.
 #include <stdint.h>
 
 #include "fonts/Adafruit_GFX.h"
+#include "fonts/ssd1309_font.h"
 
 typedef enum
 {
@@ -45,9 +46,152 @@ typedef enum
 	SSD1309_PIN_RST
 } ssd1309_pin_t;
 
+#define SSD1309_MAX_PAGES 8	 /** maximum number of pages supported by the controller (64 rows) */
+#define SSD1309_MAX_WINDOWS 32 /** maximum number of address windows per transmitted frame */
+#define SSD1309_MAX_BUFFERS 3	 /** maximum number of frame buffers (triple buffering) */
+#define SSD1309_NO_BUFFER 0xFF /** buffer index meaning "none" */
+
+// Define SSD1309_FIXED_WIDTH and SSD1309_FIXED_HEIGHT when building ssd1309.c to fold the panel
+// geometry into constants; ssd1309_init() then only accepts displays of that size.
+
+/** size of the frame buffer passed to ssd1309_init_with_buffer(): one prefix byte followed by one byte per column and page */
+#define SSD1309_BUFFER_SIZE(width, height) ((size_t)(width) * ((height) / 8) + 1)
+/** declares a static frame buffer for ssd1309_init_with_buffer() */
+#define SSD1309_STATIC_BUFFER(name, width, height) static uint8_t name[SSD1309_BUFFER_SIZE(width, height)]
+/** size of the buffer passed to ssd1309_init_strips(): one prefix byte followed by strips (1 or 2) pages */
+#define SSD1309_STRIP_BUFFER_SIZE(width, strips) ((size_t)(width) * (strips) + 1)
+/** declares a static strip buffer for ssd1309_init_strips() */
+#define SSD1309_STATIC_STRIP_BUFFER(name, width, strips) static uint8_t name[SSD1309_STRIP_BUFFER_SIZE(width, strips)]
+
 typedef bool (*ssd1309_spi_callback_t)(uint8_t *data, size_t len);
 typedef bool (*ssd1309_pin_callback_t)(ssd1309_pin_t pin, bool state);
 typedef void (*ssd1309_delay_callback_t)(uint32_t us);
+typedef bool (*ssd1309_spi_async_callback_t)(uint8_t *data, size_t len); /** starts a transfer, completion is signalled with ssd1309_transfer_complete() */
+
+/**
+ *	@brief state of an asynchronous frame transfer
+ */
+typedef enum
+{
+	SSD1309_STATE_IDLE,	   /** no transfer in progress */
+	SSD1309_STATE_COMMAND, /** address window commands in flight (DC low) */
+	SSD1309_STATE_DATA	   /** window data in flight (DC high) */
+} ssd1309_state_t;
+
+/**
+ *	@brief damaged column span per page, in buffer coordinates
+ */
+typedef struct
+{
+	uint8_t x0[SSD1309_MAX_PAGES]; /** first damaged column per page */
+	uint8_t x1[SSD1309_MAX_PAGES]; /** last damaged column per page, clean if x0 > x1 */
+} ssd1309_damage_t;
+
+/**
+ *	@brief address window of a frame transfer, in buffer coordinates
+ */
+typedef struct
+{
+	uint8_t x0;	   /** first column */
+	uint8_t x1;	   /** last column */
+	uint8_t page0; /** first page */
+	uint8_t page1; /** last page */
+} ssd1309_window_t;
+
+#ifndef SSD1309_GLYPH_CACHE_ENTRIES
+#define SSD1309_GLYPH_CACHE_ENTRIES 32 /** maximum number of glyphs held by a glyph cache */
+#endif
+
+/**
+ *	@brief glyph converted to page bytes, see ssd1309_glyph_cache_t
+ */
+typedef struct
+{
+	const GFXglyph *glyph; /** cached glyph, identifies font and character */
+	uint32_t used;		   /** LRU stamp */
+	uint16_t offset;	   /** offset of the page bytes in the data arena */
+	uint8_t shift;		   /** vertical bit offset of the glyph within its first page */
+	uint8_t pages;		   /** page bytes per column */
+} ssd1309_glyph_cache_entry_t;
+
+/**
+ *	@brief cache of GFX glyphs converted to page bytes
+ */
+typedef struct
+{
+	ssd1309_glyph_cache_entry_t entries[SSD1309_GLYPH_CACHE_ENTRIES]; /** entries, ordered by offset */
+	uint8_t count;		  /** number of entries */
+	uint8_t owned;		  /** bit 0: cache allocated by the driver, bit 1: data allocated by the driver */
+	uint8_t *data;		  /** data arena */
+	uint16_t size;		  /** size of the data arena */
+	uint16_t used_bytes;  /** bytes of the data arena in use */
+	uint32_t clock;		  /** LRU clock */
+} ssd1309_glyph_cache_t;
+
+/**
+ *	@brief how glyphs are combined with the buffer, see ssd1309_set_text_mode()
+ */
+typedef enum
+{
+	SSD1309_TEXT_TRANSPARENT,
+	SSD1309_TEXT_OPAQUE,
+	SSD1309_TEXT_INVERTED,
+	SSD1309_TEXT_XOR
+} ssd1309_text_mode_t;
+
+/**
+ *	@brief orientation of the image on the panel, see ssd1309_set_orientation()
+ */
+typedef enum
+{
+	SSD1309_ROTATE_0,	/** default orientation */
+	SSD1309_ROTATE_180, /** rotated by 180 degrees */
+	SSD1309_MIRROR_X,	/** mirrored horizontally */
+	SSD1309_MIRROR_Y,	/** mirrored vertically */
+	SSD1309_ROTATE_90,	/** rotated by 90 degrees clockwise, width and height swapped */
+	SSD1309_ROTATE_270	/** rotated by 270 degrees clockwise, width and height swapped */
+} ssd1309_orientation_t;
+
+/**
+ *	@brief frames between two steps of a hardware scroll
+ */
+typedef enum
+{
+	SSD1309_SCROLL_2_FRAMES = 0x07,
+	SSD1309_SCROLL_3_FRAMES = 0x04,
+	SSD1309_SCROLL_4_FRAMES = 0x05,
+	SSD1309_SCROLL_5_FRAMES = 0x00,
+	SSD1309_SCROLL_25_FRAMES = 0x06,
+	SSD1309_SCROLL_64_FRAMES = 0x01,
+	SSD1309_SCROLL_128_FRAMES = 0x02,
+	SSD1309_SCROLL_256_FRAMES = 0x03
+} ssd1309_scroll_speed_t;
+
+/**
+ *	@brief horizontal direction of a hardware scroll
+ */
+typedef enum
+{
+	SSD1309_SCROLL_RIGHT,
+	SSD1309_SCROLL_LEFT
+} ssd1309_scroll_direction_t;
+
+/**
+ *	@brief state of the controller's scroll engine, see ssd1309_scroll_horizontal()
+ */
+typedef struct
+{
+	bool active;						  /** scroll engine is running */
+	bool horizontal;					  /** content moves horizontally */
+	ssd1309_scroll_direction_t direction; /** direction of the horizontal movement */
+	uint8_t page0;						  /** first page moved horizontally */
+	uint8_t page1;						  /** last page moved horizontally */
+	uint8_t x0;							  /** first column moved horizontally (GDDRAM column) */
+	uint8_t x1;							  /** last column moved horizontally (GDDRAM column) */
+	uint8_t rows;						  /** rows moved up per step, 0 for horizontal scrolling only */
+	uint8_t area_top;					  /** first row of the vertical scroll area */
+	uint8_t area_rows;					  /** number of rows of the vertical scroll area */
+} ssd1309_scroll_t;
 
 /**
  *	@brief struct representing ssd1309 display
@@ -57,13 +201,146 @@ typedef struct
 	uint8_t width;			  /** width of display */
 	uint8_t height;			  /** height of display */
 	uint8_t pages;			  /** stores pages of display (calculated on initialization */
-	uint8_t *buffer;		  /** display buffer */
+	uint8_t *buffer;		  /** display buffer (back buffer drawn to) */
 	size_t bufsize;			  /** buffer size */
 	ssd1309_spi_callback_t spi_cb; /** SPI callback */
 	ssd1309_pin_callback_t pin_cb; /** pin callback */
 	ssd1309_delay_callback_t delay;
+	ssd1309_damage_t dirty;	  /** damage drawn since the last transmitted or queued frame */
+	uint8_t *shadow;		  /** copy of the controller's GDDRAM, NULL if diffing is disabled */
+	bool shadow_owned;		  /** shadow was allocated by the driver */
+	bool shadow_valid;		  /** shadow reflects the GDDRAM content */
+	ssd1309_spi_async_callback_t spi_async_cb; /** asynchronous SPI callback, NULL if not used */
+	volatile bool transfer_done;			   /** set by ssd1309_transfer_complete() */
+	ssd1309_state_t state;					   /** state of the asynchronous transfer */
+	ssd1309_window_t windows[SSD1309_MAX_WINDOWS]; /** windows of the frame being transmitted */
+	uint8_t window_count;	  /** number of windows in the frame */
+	uint8_t window_index;	  /** window currently transmitted */
+	uint8_t window_page;	  /** page currently transmitted within the window */
+	uint8_t window_cmds[6];	  /** command bytes of the current window, kept alive during the transfer */
+	uint8_t *tx_buffer;		  /** buffer the frame data is transmitted from */
+	uint8_t *buffers[SSD1309_MAX_BUFFERS]; /** frame buffers, buffers[0] is the one set up by ssd1309_init() */
+	uint8_t buffer_count;	  /** number of frame buffers */
+	uint8_t buffers_owned;	  /** bit mask of buffers allocated by the driver */
+	uint8_t back;			  /** index of the buffer drawn to */
+	uint8_t front;			  /** index of the buffer in flight, SSD1309_NO_BUFFER if none */
+	uint8_t queued;			  /** index of the frame waiting for the transport, SSD1309_NO_BUFFER if none */
+	ssd1309_damage_t queued_dirty; /** damage of the queued frame */
+	ssd1309_glyph_cache_t *glyph_cache; /** glyph cache, NULL if disabled */
+	int16_t clip_x0;					/** left edge of the clip rectangle */
+	int16_t clip_y0;					/** top edge of the clip rectangle */
+	int16_t clip_x1;					/** right edge of the clip rectangle (inclusive, -1 if empty) */
+	int16_t clip_y1;					/** bottom edge of the clip rectangle (inclusive, -1 if empty) */
+	const GFXfont *font;				/** font of the functions without a font parameter */
+	ssd1309_text_mode_t text_mode;		/** how glyphs are combined with the buffer */
+	const void *cell_font;				/** glyph table of the font cell_top and cell_bottom belong to */
+	int8_t cell_top;					/** top of the character cells relative to the baseline */
+	int8_t cell_bottom;					/** bottom of the character cells relative to the baseline (exclusive) */
+	ssd1309_orientation_t orientation;	/** orientation set by ssd1309_set_orientation() */
+	bool transposed;					/** drawing coordinates are swapped (90 and 270 degrees) */
+	uint8_t column_offset;				/** GDDRAM column of buffer column 0 */
+	uint8_t start_line;					/** GDDRAM row shown on the first COM line */
+	ssd1309_scroll_t scroll;			/** hardware scroll state */
+	uint8_t strips;						/** number of page strips, 0 with a full frame buffer (see ssd1309_init_strips()) */
+	uint8_t buffer_page;				/** page held by buffer in strip mode (SSD1309_NO_BUFFER outside of ssd1309_render()), 0 otherwise */
+	uint8_t tx_page;					/** page held by tx_buffer */
 } ssd1309_t;
 
+typedef void (*ssd1309_draw_callback_t)(ssd1309_t *p, void *ctx); /** draws a frame, see ssd1309_render() */
+
+/**
+ *	@brief pen state of text drawn character by character, see ssd1309_text_begin()
+ */
+typedef struct
+{
+	ssd1309_t *p;		 /** display drawn to */
+	const GFXfont *font; /** font used */
+	int32_t x;			 /** x coordinate of the pen */
+	int32_t y;			 /** y coordinate of the pen */
+	int32_t left;		 /** x coordinate the pen returns to on '\n' */
+	uint32_t scale;		 /** scale of char */
+	bool clipped;		 /** rest of the line lies outside of the clip rectangle */
+} ssd1309_text_stream_t;
+
+/**
+ *	@brief log view scrolled by the display start line, see ssd1309_terminal_init()
+ */
+typedef struct
+{
+	ssd1309_t *p;		 /** display written to */
+	const GFXfont *font; /** font, glyphs are clipped to one page */
+	char *lines;		 /** history of capacity lines of columns characters each */
+	uint16_t capacity;	 /** number of lines in the history */
+	uint8_t columns;	 /** characters per line */
+	uint8_t rows;		 /** lines on the display */
+	int8_t baseline;	 /** baseline of the text within a page */
+	uint8_t cursor;		 /** column of the next character */
+	bool line_dirty;	 /** current line changed since it was last transmitted */
+	uint8_t top_page;	 /** GDDRAM page shown at the top of the display */
+	uint32_t total;		 /** number of lines started, the current line is total - 1 */
+	uint16_t count;		 /** number of lines in the history, including the current one */
+	uint16_t view;		 /** lines scrolled back from the newest line */
+	uint32_t top_line;	 /** line shown at the top of the display */
+} ssd1309_terminal_t;
+
+#ifndef SSD1309_FIELD_CHARS
+#define SSD1309_FIELD_CHARS 12 /** maximum number of cells of a numeric field, enough for any int32_t */
+#endif
+
+/**
+ *	@brief right-aligned numeric field that redraws only the cells that changed, see ssd1309_field_init()
+ */
+typedef struct
+{
+	const GFXfont *font;			/** font used */
+	int32_t x;						/** x coordinate of the left edge of the first cell */
+	int32_t y;						/** y coordinate of the pen (baseline for GFX fonts) */
+	uint32_t scale;					/** scale of char */
+	uint8_t width;					/** number of cells */
+	uint8_t decimals;				/** digits after the decimal point */
+	char pad;						/** fill character left of the number, ' ' or '0' */
+	bool valid;						/** text reflects what is drawn */
+	uint16_t cell_width;			/** width of a cell in pixels */
+	uint16_t cell_height;			/** height of a cell in pixels */
+	int16_t cell_top;				/** top of a cell relative to y */
+	char text[SSD1309_FIELD_CHARS]; /** characters drawn in the cells */
+} ssd1309_field_t;
+
+#define SSD1309_CELL_INVERSE 0x01	/** cell is drawn with the colors swapped */
+#define SSD1309_CELL_UNDERLINE 0x02 /** bottom row of the cell is inverted */
+#define SSD1309_CELL_DIRTY 0x80		/** cell changed since the last flush (set by the driver) */
+
+/**
+ *	@brief character and attributes of a console cell
+ */
+typedef struct
+{
+	char c;		  /** character */
+	uint8_t attr; /** SSD1309_CELL_* flags */
+} ssd1309_cell_t;
+
+/**
+ *	@brief grid of character cells that redraws only the cells that changed, see ssd1309_console_init()
+ */
+typedef struct
+{
+	ssd1309_t *p;		   /** display drawn to */
+	const GFXfont *font;   /** font used */
+	uint32_t scale;		   /** scale of char */
+	int32_t x;			   /** x coordinate of the left edge of the grid */
+	int32_t y;			   /** y coordinate of the top edge of the grid */
+	ssd1309_cell_t *cells; /** cells, row by row */
+	uint8_t columns;	   /** cells per row */
+	uint8_t rows;		   /** number of rows */
+	uint16_t cell_width;   /** width of a cell in pixels */
+	uint16_t cell_height;  /** height of a cell in pixels */
+	int16_t baseline;	   /** baseline relative to the top of a cell */
+	uint8_t cursor_x;	   /** column of the next character */
+	uint8_t cursor_y;	   /** row of the next character */
+	uint8_t attr;		   /** attributes of the next characters */
+	uint16_t dirty;		   /** number of dirty cells */
+} ssd1309_console_t;
+
 enum cursor_type
 {
 	CURSOR_NONE,
@@ -73,39 +350,200 @@ enum cursor_type
 
 typedef struct
 {
-	uint8_t width;
-	uint8_t height;
+	uint16_t width;
+	uint16_t height;
 } vector2_t;
 
+/**
+ *	@brief horizontal alignment of text lines, see ssd1309_draw_text_box_with_font()
+ */
+typedef enum
+{
+	SSD1309_ALIGN_LEFT,
+	SSD1309_ALIGN_CENTER,
+	SSD1309_ALIGN_RIGHT
+} ssd1309_align_t;
+
+#define SSD1309_TEXT_WRAP 0x01	   /** break lines at spaces (or inside words that do not fit) */
+#define SSD1309_TEXT_ELLIPSIS 0x02 /** end text that does not fit with "..." */
+
+/**
+ *	@brief box covered by the set pixels of a string, relative to the position it is drawn at
+ */
+typedef struct
+{
+	int16_t x;		 /** left edge */
+	int16_t y;		 /** top edge */
+	uint16_t width;	 /** width, 0 if nothing is drawn */
+	uint16_t height; /** height, 0 if nothing is drawn */
+} ssd1309_bounds_t;
+
+#define SSD1309_NODE_HIDDEN 0x01 /** node is not drawn */
+#define SSD1309_NODE_FILLED 0x02 /** rectangle is filled instead of outlined */
+#define SSD1309_NODE_INVERT 0x04 /** filled rectangle, text or bitmap inverts the pixels below instead of setting them */
+
+/**
+ *	@brief kind of a display list node
+ */
+typedef enum
+{
+	SSD1309_NODE_RECT,
+	SSD1309_NODE_LINE,
+	SSD1309_NODE_TEXT,
+	SSD1309_NODE_BITMAP
+} ssd1309_node_type_t;
+
+/**
+ *	@brief element of a display list, see ssd1309_scene_init()
+ */
+typedef struct
+{
+	ssd1309_node_type_t type; /** kind of node */
+	uint8_t flags;			  /** SSD1309_NODE_* flags */
+	int16_t x;				  /** left edge (rectangle, bitmap), first end (line) or pen (text) */
+	int16_t y;				  /** top edge (rectangle, bitmap), first end (line) or baseline (text) */
+	int16_t x2;				  /** second end (line) */
+	int16_t y2;				  /** second end (line) */
+	uint16_t width;			  /** width (rectangle, bitmap) */
+	uint16_t height;		  /** height (rectangle, bitmap) */
+	const GFXfont *font;	  /** font (text) */
+	uint32_t scale;			  /** scale of char (text) */
+	const char *text;		  /** string (text) */
+	const uint8_t *bitmap;	  /** pixels in display RAM order, see ssd1309_draw_bitmap() (bitmap) */
+	ssd1309_bounds_t bounds;  /** pixels covered on the display when last updated (set by the driver) */
+} ssd1309_node_t;
+
+#ifndef SSD1309_SCENE_RECTS
+#define SSD1309_SCENE_RECTS 8 /** damage rectangles kept by a scene before the closest ones are merged */
+#endif
+
+/**
+ *	@brief display list that only redraws what changed, see ssd1309_scene_init()
+ */
+typedef struct
+{
+	ssd1309_t *p;								 /** display drawn to */
+	ssd1309_node_t *nodes;						 /** nodes in drawing order */
+	uint8_t count;								 /** number of nodes */
+	uint8_t damage_count;						 /** number of damage rectangles */
+	ssd1309_bounds_t damage[SSD1309_SCENE_RECTS]; /** areas to redraw, disjoint */
+} ssd1309_scene_t;
+
+/**
+ *	@brief how an image is combined with the buffer, see ssd1309_bmp_draw()
+ */
+typedef enum
+{
+	SSD1309_BLEND_COPY, /** pixels of the image replace the buffer, unset pixels are cleared */
+	SSD1309_BLEND_OR,	/** set pixels are drawn, unset pixels are left alone */
+	SSD1309_BLEND_XOR	/** set pixels invert the buffer */
+} ssd1309_blend_t;
+
 bool ssd1309_init(ssd1309_t *p, uint16_t width, uint16_t height, ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb);
+bool ssd1309_init_with_buffer(ssd1309_t *p, uint16_t width, uint16_t height, uint8_t *buffer, size_t size, ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb);
+bool ssd1309_init_strips(ssd1309_t *p, uint16_t width, uint16_t height, uint8_t *buffer, size_t size, ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb);
 void ssd1309_deinit(ssd1309_t *p);
 
 void ssd1309_reset(ssd1309_t *p);
+void ssd1309_write_commands(ssd1309_t *p, const uint8_t *cmds, size_t len);
 void ssd1309_power(ssd1309_t *p, bool on);
 void ssd1309_contrast(ssd1309_t *p, uint8_t val);
 void ssd1309_invert(ssd1309_t *p, bool inv);
+void ssd1309_set_orientation(ssd1309_t *p, ssd1309_orientation_t orientation);
+vector2_t ssd1309_get_size(const ssd1309_t *p);
+
+bool ssd1309_scroll_horizontal(ssd1309_t *p, ssd1309_scroll_direction_t direction, uint8_t page0, uint8_t page1, uint8_t x0, uint8_t x1, ssd1309_scroll_speed_t speed);
+bool ssd1309_scroll_diagonal(ssd1309_t *p, ssd1309_scroll_direction_t direction, uint8_t page0, uint8_t page1, uint8_t rows, ssd1309_scroll_speed_t speed);
+bool ssd1309_scroll_vertical(ssd1309_t *p, uint8_t rows, ssd1309_scroll_speed_t speed);
+bool ssd1309_set_scroll_area(ssd1309_t *p, uint8_t top, uint8_t rows);
+bool ssd1309_scroll_content(ssd1309_t *p, ssd1309_scroll_direction_t direction, uint8_t page0, uint8_t page1, uint8_t x0, uint8_t x1);
+void ssd1309_scroll_stop(ssd1309_t *p, uint32_t steps);
+
+bool ssd1309_terminal_init(ssd1309_terminal_t *t, ssd1309_t *p, const GFXfont *font, char *history, size_t size);
+void ssd1309_terminal_putc(char c, void *terminal);
+void ssd1309_terminal_puts(ssd1309_terminal_t *t, const char *s);
+void ssd1309_terminal_flush(ssd1309_terminal_t *t);
+void ssd1309_terminal_scroll(ssd1309_terminal_t *t, int32_t lines);
+void ssd1309_terminal_end(ssd1309_terminal_t *t);
+
+bool ssd1309_shadow_enable(ssd1309_t *p, uint8_t *shadow);
+void ssd1309_shadow_disable(ssd1309_t *p);
 
 void ssd1309_show(ssd1309_t *p);
+void ssd1309_set_async(ssd1309_t *p, ssd1309_spi_async_callback_t spi_async_cb);
+bool ssd1309_show_async(ssd1309_t *p);
+bool ssd1309_poll(ssd1309_t *p);
+bool ssd1309_set_buffers(ssd1309_t *p, uint8_t *const *extra, uint8_t count);
+void ssd1309_swap(ssd1309_t *p);
+void ssd1309_render(ssd1309_t *p, ssd1309_draw_callback_t draw, void *ctx);
+void ssd1309_transfer_complete(ssd1309_t *p);
+void ssd1309_invalidate(ssd1309_t *p);
 void ssd1309_clear(ssd1309_t *p);
+void ssd1309_set_clip(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height);
+void ssd1309_reset_clip(ssd1309_t *p);
 
 void ssd1309_clear_pixel(ssd1309_t *p, uint32_t x, uint32_t y);
 void ssd1309_draw_pixel(ssd1309_t *p, uint32_t x, uint32_t y);
 void ssd1309_invert_pixel(ssd1309_t *p, uint32_t x, uint32_t y);
 void ssd1309_draw_line(ssd1309_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
 void ssd1309_draw_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+void ssd1309_clear_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 void ssd1309_draw_empty_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 void ssd1309_invert_square(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+void ssd1309_draw_bitmap(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height, const uint8_t *bitmap);
 
 void ssd1309_bmp_show_image_with_offset(ssd1309_t *p, const uint8_t *data, long size, uint32_t x_offset, uint32_t y_offset);
 void ssd1309_bmp_show_image(ssd1309_t *p, const uint8_t *data, long size);
+bool ssd1309_bmp_draw(ssd1309_t *p, const uint8_t *data, size_t size, int32_t x, int32_t y, ssd1309_blend_t blend, uint8_t threshold);
+
+bool ssd1309_glyph_cache_enable(ssd1309_t *p, ssd1309_glyph_cache_t *cache, uint8_t *data, uint16_t size);
+void ssd1309_glyph_cache_disable(ssd1309_t *p);
 
 uint8_t ssd1309_draw_char_with_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const GFXfont font, char c);
 void ssd1309_draw_char(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, char c);
 void ssd1309_draw_string_with_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const GFXfont font, const char *s);
 void ssd1309_draw_string(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *s);
+void ssd1309_set_font(ssd1309_t *p, const GFXfont *font);
+void ssd1309_set_text_mode(ssd1309_t *p, ssd1309_text_mode_t mode);
+
+void ssd1309_text_begin(ssd1309_text_stream_t *stream, ssd1309_t *p, int32_t x, int32_t y, uint32_t scale);
+void ssd1309_text_putc(char c, void *stream);
+void ssd1309_text_puts(ssd1309_text_stream_t *stream, const char *s);
+
+void ssd1309_field_init(ssd1309_field_t *field, const GFXfont *font, int32_t x, int32_t y, uint32_t scale, uint8_t width, uint8_t decimals);
+void ssd1309_field_set(ssd1309_t *p, ssd1309_field_t *field, int32_t value);
+void ssd1309_field_invalidate(ssd1309_field_t *field);
+
+bool ssd1309_console_init(ssd1309_console_t *con, ssd1309_t *p, const GFXfont *font, uint32_t scale, int32_t x, int32_t y, ssd1309_cell_t *cells, uint8_t columns, uint8_t rows);
+void ssd1309_console_set(ssd1309_console_t *con, uint8_t column, uint8_t row, char c, uint8_t attr);
+void ssd1309_console_move(ssd1309_console_t *con, uint8_t column, uint8_t row);
+void ssd1309_console_set_attr(ssd1309_console_t *con, uint8_t attr);
+void ssd1309_console_putc(char c, void *console);
+void ssd1309_console_puts(ssd1309_console_t *con, const char *s);
+void ssd1309_console_clear(ssd1309_console_t *con);
+void ssd1309_console_flush(ssd1309_console_t *con);
+
+void ssd1309_node_rect(ssd1309_node_t *n, int32_t x, int32_t y, uint32_t width, uint32_t height, uint8_t flags);
+void ssd1309_node_line(ssd1309_node_t *n, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint8_t flags);
+void ssd1309_node_text(ssd1309_node_t *n, const GFXfont *font, uint32_t scale, int32_t x, int32_t y, const char *s, uint8_t flags);
+void ssd1309_node_bitmap(ssd1309_node_t *n, int32_t x, int32_t y, uint32_t width, uint32_t height, const uint8_t *bitmap, uint8_t flags);
+void ssd1309_scene_init(ssd1309_scene_t *scene, ssd1309_t *p, ssd1309_node_t *nodes, uint8_t count);
+void ssd1309_scene_update(ssd1309_scene_t *scene, ssd1309_node_t *n);
+void ssd1309_scene_flush(ssd1309_scene_t *scene);
+void ssd1309_scene_draw(ssd1309_t *p, void *scene);
+
+uint8_t ssd1309_draw_char_with_packed_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const ssd1309_font_t font, char c);
+void ssd1309_draw_string_with_packed_font(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const ssd1309_font_t font, const char *s);
+
+const char *ssd1309_draw_text_box_with_font(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t scale, const GFXfont font, ssd1309_align_t align, uint8_t flags, const char *s);
+const char *ssd1309_draw_text_box(ssd1309_t *p, int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t scale, ssd1309_align_t align, uint8_t flags, const char *s);
 
 vector2_t ssd1309_get_string_size_with_font(const GFXfont font, const char *s);
 vector2_t ssd1309_get_string_size(const char *s);
+vector2_t ssd1309_get_scaled_string_size_with_font(const GFXfont font, uint32_t scale, const char *s);
+vector2_t ssd1309_get_scaled_string_size_with_packed_font(const ssd1309_font_t font, uint32_t scale, const char *s);
+ssd1309_bounds_t ssd1309_get_string_bounds_with_font(const GFXfont font, uint32_t scale, const char *s);
+ssd1309_bounds_t ssd1309_get_string_bounds_with_packed_font(const ssd1309_font_t font, uint32_t scale, const char *s);
 
 void ssd1309_printf(ssd1309_t *p, uint32_t x, uint32_t y, uint32_t scale, const char *fmt, ...);
 
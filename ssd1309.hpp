@@ -0,0 +1,159 @@
+/*
+MIT License
+
+Copyright (c) 2021 David Schramm
+              2024 Cédric Hirschi
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ssd1309.hpp
+ *
+ * @brief C++ wrapper for displays with a geometry fixed at compile time
+ *
+ * ssd1309::Display<W, H> owns its frame buffer (no heap) and draws pixels
+ * inline with W and H as constants, so the page arithmetic and the bounds
+ * checks fold into immediates and shifts. All
+ * other drawing is forwarded to the C API. Build ssd1309.c with
+ * SSD1309_FIXED_WIDTH=W and SSD1309_FIXED_HEIGHT=H to specialize it as well.
+ */
+
+#ifndef _inc_ssd1309_hpp
+#define _inc_ssd1309_hpp
+
+extern "C"
+{
+#include "ssd1309.h"
+}
+
+namespace ssd1309
+{
+
+template <uint8_t Width, uint8_t Height>
+class Display
+{
+    static_assert(Width >= 1 && Width <= 128, "SSD1309 supports up to 128 columns");
+    static_assert(Height >= 8 && Height <= SSD1309_MAX_PAGES * 8, "SSD1309 supports 8 to 64 rows");
+#ifdef SSD1309_FIXED_WIDTH
+    static_assert(Width == SSD1309_FIXED_WIDTH, "Width differs from SSD1309_FIXED_WIDTH");
+#endif
+#ifdef SSD1309_FIXED_HEIGHT
+    static_assert(Height == SSD1309_FIXED_HEIGHT, "Height differs from SSD1309_FIXED_HEIGHT");
+#endif
+
+public:
+    static constexpr uint8_t width = Width;
+    static constexpr uint8_t height = Height;
+    static constexpr uint8_t pages = Height / 8;
+
+    Display() = default;
+    Display(const Display &) = delete;
+    Display &operator=(const Display &) = delete;
+
+    ~Display()
+    {
+        if (initialized_)
+            ssd1309_deinit(&dev_);
+    }
+
+    /**
+     * @brief Initialize the display with the built-in frame buffer
+     *
+     * @return false if initialization failed
+     */
+    bool init(ssd1309_spi_callback_t spi_cb, ssd1309_pin_callback_t pin_cb, ssd1309_delay_callback_t delay_cb)
+    {
+        initialized_ = ssd1309_init_with_buffer(&dev_, Width, Height, buffer_, sizeof(buffer_), spi_cb, pin_cb, delay_cb);
+        return initialized_;
+    }
+
+    /**
+     * @brief Instance for the functions of the C API
+     */
+    ssd1309_t *get() { return &dev_; }
+
+    void draw_pixel(uint32_t x, uint32_t y) { pixel<Op::Set>(x, y); }
+    void clear_pixel(uint32_t x, uint32_t y) { pixel<Op::Clear>(x, y); }
+    void invert_pixel(uint32_t x, uint32_t y) { pixel<Op::Invert>(x, y); }
+
+    void set_orientation(ssd1309_orientation_t orientation) { ssd1309_set_orientation(&dev_, orientation); }
+
+    void clear() { ssd1309_clear(&dev_); }
+    void show() { ssd1309_show(&dev_); }
+    void draw_line(int32_t x1, int32_t y1, int32_t x2, int32_t y2) { ssd1309_draw_line(&dev_, x1, y1, x2, y2); }
+    void draw_square(uint32_t x, uint32_t y, uint32_t w, uint32_t h) { ssd1309_draw_square(&dev_, x, y, w, h); }
+    void clear_square(uint32_t x, uint32_t y, uint32_t w, uint32_t h) { ssd1309_clear_square(&dev_, x, y, w, h); }
+    void invert_square(uint32_t x, uint32_t y, uint32_t w, uint32_t h) { ssd1309_invert_square(&dev_, x, y, w, h); }
+    void draw_string(uint32_t x, uint32_t y, uint32_t scale, const char *s) { ssd1309_draw_string(&dev_, x, y, scale, s); }
+    void draw_string(uint32_t x, uint32_t y, uint32_t scale, const GFXfont &font, const char *s) { ssd1309_draw_string_with_font(&dev_, x, y, scale, font, s); }
+
+private:
+    enum class Op
+    {
+        Set,
+        Clear,
+        Invert
+    };
+
+    template <Op op>
+    void pixel(uint32_t x, uint32_t y)
+    {
+        // Rotations by 90 and 270 degrees take the transposed path of the C API
+        if (dev_.transposed)
+        {
+            if (op == Op::Set)
+                ssd1309_draw_pixel(&dev_, x, y);
+            else if (op == Op::Clear)
+                ssd1309_clear_pixel(&dev_, x, y);
+            else
+                ssd1309_invert_pixel(&dev_, x, y);
+            return;
+        }
+
+        if (x >= Width || y >= Height)
+            return;
+        if ((int32_t)x < dev_.clip_x0 || (int32_t)x > dev_.clip_x1 || (int32_t)y < dev_.clip_y0 || (int32_t)y > dev_.clip_y1)
+            return;
+
+        const uint8_t page = y / 8;
+        const uint8_t bit = 1 << (y & 7);
+
+        uint8_t *byte = &dev_.buffer[x + page * Width];
+        if (op == Op::Set)
+            *byte |= bit;
+        else if (op == Op::Clear)
+            *byte &= ~bit;
+        else
+            *byte ^= bit;
+
+        if (x < dev_.dirty.x0[page])
+            dev_.dirty.x0[page] = x;
+        if (x > dev_.dirty.x1[page])
+            dev_.dirty.x1[page] = x;
+    }
+
+    ssd1309_t dev_;
+    uint8_t buffer_[SSD1309_BUFFER_SIZE(Width, Height)];
+    bool initialized_ = false;
+};
+
+} // namespace ssd1309
+
+#endif
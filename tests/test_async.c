@@ -0,0 +1,307 @@
+/**
+ * @file test_async.c
+ *
+ * Host-side test of ssd1309_show_async() and ssd1309_poll(). A fake
+ * asynchronous transport only records each transfer; a periodic timer signal
+ * stands in for the DMA interrupt and completes it a few ticks later with
+ * ssd1309_transfer_complete(), while the test keeps drawing between ticks.
+ * The bytes of a transfer are read when it completes, like a DMA engine
+ * would, and fed to an emulated GDDRAM, which must equal the frame buffer
+ * once the transfers are drained. The DC level of every phase and the
+ * release of CS between phases are checked along the way.
+ *
+ * Build and run on a POSIX host:
+ *
+ *     cc -I. -Ifonts -o test_async tests/test_async.c ssd1309.c
+ *     ./test_async
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "ssd1309.h"
+
+#define WIDTH 128
+#define HEIGHT 64
+
+static int failures;
+
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            if (failures < 10)                                              \
+                printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++failures;                                                     \
+        }                                                                   \
+    } while (0)
+
+static ssd1309_t display;
+
+// Pins
+static volatile bool dc;
+static volatile bool cs = true;
+
+// Emulated GDDRAM, horizontal addressing mode
+static uint8_t gram[8][128];
+static uint8_t col0, col1 = 127, page0, page1 = 7, col, page;
+static uint8_t cmd[3];
+static uint8_t cmd_len;
+
+// Transfer in flight on the fake transport
+static uint8_t *volatile pending;
+static size_t pending_len;
+static bool pending_dc;
+static volatile int pending_ticks;
+
+static void emu_command(uint8_t b)
+{
+    cmd[cmd_len++] = b;
+
+    const uint8_t c = cmd[0];
+    const uint8_t args = (c == 0x21 || c == 0x22) ? 2 : (c == 0x20 || c == 0x81 || c == 0xA8 || c == 0xD3 || c == 0xD5 || c == 0xD9 || c == 0xDA || c == 0xDB || c == 0xFD) ? 1 : 0;
+    if (cmd_len < args + 1)
+        return;
+
+    if (c == 0x21)
+    {
+        col0 = col = cmd[1];
+        col1 = cmd[2];
+    }
+    else if (c == 0x22)
+    {
+        page0 = page = cmd[1];
+        page1 = cmd[2];
+    }
+    cmd_len = 0;
+}
+
+static void emu_data(uint8_t b)
+{
+    gram[page][col] = b;
+    if (++col > col1)
+    {
+        col = col0;
+        if (++page > page1)
+            page = page0;
+    }
+}
+
+static void emu_bytes(bool data, const uint8_t *bytes, size_t len)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (data)
+            emu_data(bytes[i]);
+        else
+            emu_command(bytes[i]);
+    }
+}
+
+static bool fake_pin(ssd1309_pin_t pin, bool state)
+{
+    if (pin == SSD1309_PIN_DC)
+    {
+        CHECK(cs); // DC may only change while CS is released
+        dc = state;
+    }
+    else if (pin == SSD1309_PIN_CS)
+    {
+        if (!state)
+            CHECK(cs); // Every phase starts with a falling edge of CS
+        else
+            CHECK(pending == NULL); // CS is not released while a transfer is in flight
+        cs = state;
+    }
+    return true;
+}
+
+static bool fake_spi(uint8_t *data, size_t len)
+{
+    CHECK(!cs);
+    CHECK(pending == NULL);
+    emu_bytes(dc, data, len);
+    return true;
+}
+
+static void fake_delay(uint32_t us)
+{
+    (void)us;
+}
+
+static bool fake_spi_async(uint8_t *data, size_t len)
+{
+    CHECK(!cs);
+    CHECK(pending == NULL);
+
+    // A command phase carries exactly one address window
+    if (!dc)
+        CHECK(len == 6 && data[0] == 0x21 && data[3] == 0x22);
+    if (display.state == SSD1309_STATE_COMMAND)
+        CHECK(!dc);
+    if (display.state == SSD1309_STATE_DATA)
+        CHECK(dc);
+
+    pending_len = len;
+    pending_dc = dc;
+    pending_ticks = rand() % 4;
+    pending = data;
+    return true;
+}
+
+/**
+ * @brief Timer signal handler playing the DMA engine and its completion interrupt
+ */
+static void tick(int sig)
+{
+    (void)sig;
+
+    if (pending == NULL || pending_ticks-- > 0)
+        return;
+
+    CHECK(!cs);
+    CHECK(dc == pending_dc);
+    emu_bytes(pending_dc, pending, pending_len);
+    pending = NULL;
+    ssd1309_transfer_complete(&display);
+}
+
+static void drain(void)
+{
+    while (ssd1309_poll(&display))
+        ;
+}
+
+static bool gram_matches(void)
+{
+    for (uint8_t pg = 0; pg < HEIGHT / 8; ++pg)
+        if (memcmp(gram[pg], display.buffer + pg * WIDTH, WIDTH) != 0)
+            return false;
+    return true;
+}
+
+static void draw_something(int frame)
+{
+    if (rand() % 4 == 0)
+        ssd1309_clear(&display);
+    ssd1309_printf(&display, rand() % 16, rand() % 8, 1, "%d", frame);
+    for (int i = 0; i < 10; ++i)
+        ssd1309_draw_pixel(&display, rand() % WIDTH, rand() % HEIGHT);
+    ssd1309_invert_square(&display, rand() % WIDTH, rand() % HEIGHT, rand() % 40, rand() % 20);
+}
+
+/**
+ * @brief Shadow enabled: keep drawing into the buffer while frames are sent from the shadow
+ */
+static void test_shadow(void)
+{
+    CHECK(ssd1309_init(&display, WIDTH, HEIGHT, fake_spi, fake_pin, fake_delay));
+    CHECK(ssd1309_shadow_enable(&display, NULL));
+    ssd1309_set_async(&display, fake_spi_async);
+
+    for (int frame = 0; frame < 500; ++frame)
+    {
+        draw_something(frame);
+        ssd1309_show_async(&display);
+        for (int i = rand() % 8; i > 0; --i)
+        {
+            ssd1309_poll(&display);
+            if (rand() % 2)
+                draw_something(frame);
+        }
+
+        if (frame % 50 == 49)
+        {
+            drain();
+            CHECK(ssd1309_show_async(&display));
+            drain();
+            CHECK(gram_matches());
+        }
+    }
+
+    drain();
+    CHECK(ssd1309_show_async(&display));
+    drain();
+    CHECK(display.state == SSD1309_STATE_IDLE);
+    CHECK(gram_matches());
+    ssd1309_deinit(&display);
+}
+
+/**
+ * @brief No shadow: the buffer is left alone until ssd1309_poll() reports the frame as sent
+ */
+static void test_direct(void)
+{
+    CHECK(ssd1309_init(&display, WIDTH, HEIGHT, fake_spi, fake_pin, fake_delay));
+    ssd1309_set_async(&display, fake_spi_async);
+
+    for (int frame = 0; frame < 500; ++frame)
+    {
+        draw_something(frame);
+        CHECK(ssd1309_show_async(&display));
+        drain();
+        CHECK(gram_matches());
+    }
+
+    ssd1309_deinit(&display);
+}
+
+/**
+ * @brief Double and triple buffering: frames are handed over with ssd1309_swap()
+ */
+static void test_swap(uint8_t extra)
+{
+    CHECK(ssd1309_init(&display, WIDTH, HEIGHT, fake_spi, fake_pin, fake_delay));
+    CHECK(ssd1309_set_buffers(&display, NULL, extra));
+    ssd1309_set_async(&display, fake_spi_async);
+
+    for (int frame = 0; frame < 500; ++frame)
+    {
+        draw_something(frame);
+        ssd1309_swap(&display);
+        for (int i = rand() % 8; i > 0; --i)
+            ssd1309_poll(&display);
+    }
+
+    drain();
+    ssd1309_show(&display);
+    CHECK(gram_matches());
+    ssd1309_deinit(&display);
+}
+
+int main(void)
+{
+    const struct itimerval period = {{0, 50}, {0, 50}};
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = tick;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    srand(1);
+    sigaction(SIGALRM, &action, NULL);
+    setitimer(ITIMER_REAL, &period, NULL);
+
+    test_shadow();
+    test_direct();
+    test_swap(1);
+    test_swap(2);
+
+    if (failures != 0)
+    {
+        printf("%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,380 @@
+/**
+ * @file fontconv.c
+ *
+ * Converts Adafruit GFX font headers or BDF fonts into the page-major font
+ * format of fonts/ssd1309_font.h, so glyphs can be drawn column by column
+ * without transposing bits on the target.
+ *
+ * Build and run on the host:
+ *
+ *     cc -O2 -o fontconv tools/fontconv.c
+ *     ./fontconv fonts/FreeMono9pt7b.h > fonts/FreeMono9pt7bPacked.h
+ *     ./fontconv -f 0x20 -l 0x7E -n MyFont my_font.bdf > fonts/MyFont.h
+ *
+ * Options:
+ *     -f <code>  first character (BDF only, default 0x20)
+ *     -l <code>  last character (BDF only, default 0x7E)
+ *     -n <name>  name of the generated font (default: <GFX font name>Packed,
+ *                or the BDF file name)
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_GLYPHS 65536
+
+typedef struct
+{
+    uint8_t *rows; // row-major bitmap, one byte per pixel
+    uint8_t width;
+    uint8_t height;
+    uint8_t xAdvance;
+    int8_t xOffset;
+    int8_t yOffset;
+} glyph_t;
+
+typedef struct
+{
+    char name[128];
+    uint16_t first;
+    uint16_t last;
+    uint8_t yAdvance;
+    glyph_t *glyphs; // last - first + 1 entries
+} font_t;
+
+static void die(const char *msg, const char *arg)
+{
+    fprintf(stderr, "fontconv: %s%s%s\n", msg, arg ? ": " : "", arg ? arg : "");
+    exit(1);
+}
+
+static char *read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        die("cannot open", path);
+
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *text = malloc(size + 1);
+    if (text == NULL || fread(text, 1, size, f) != (size_t)size)
+        die("cannot read", path);
+    text[size] = '\0';
+    fclose(f);
+
+    return text;
+}
+
+static void identifier_from_path(char *dst, size_t len, const char *path)
+{
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+
+    size_t i = 0;
+    for (; base[i] && base[i] != '.' && i + 1 < len; ++i)
+        dst[i] = isalnum((unsigned char)base[i]) ? base[i] : '_';
+    dst[i] = '\0';
+}
+
+/* ---------------------------------------------------------------- GFX ---- */
+
+static void strip_comments(char *s)
+{
+    for (char *c = s; *c; ++c)
+    {
+        if (c[0] == '/' && c[1] == '/')
+        {
+            while (*c && *c != '\n')
+                *c++ = ' ';
+        }
+        else if (c[0] == '/' && c[1] == '*')
+        {
+            while (*c && !(c[0] == '*' && c[1] == '/'))
+                *c++ = ' ';
+            if (*c)
+            {
+                c[0] = c[1] = ' ';
+                ++c;
+            }
+        }
+        if (!*c)
+            break;
+    }
+}
+
+/**
+ * Collects the numbers of the initializer following "<type> ... = {", skipping
+ * identifiers and casts. Returns a pointer behind the initializer.
+ */
+static char *parse_initializer(char *s, const char *type, long **values, size_t *count)
+{
+    char *decl = strstr(s, type);
+    if (decl == NULL)
+        return NULL;
+
+    char *open = strchr(decl, '{');
+    if (open == NULL)
+        return NULL;
+
+    size_t cap = 1024;
+    *values = malloc(cap * sizeof(long));
+    *count = 0;
+
+    int depth = 0;
+    char *c = open;
+    for (; *c; ++c)
+    {
+        if (*c == '{')
+            ++depth;
+        else if (*c == '}' && --depth == 0)
+            break;
+        else if (isalpha((unsigned char)*c) || *c == '_')
+        {
+            while (isalnum((unsigned char)*c) || *c == '_')
+                ++c;
+            --c;
+        }
+        else if (isdigit((unsigned char)*c) || (*c == '-' && isdigit((unsigned char)c[1])))
+        {
+            char *end;
+            const long v = strtol(c, &end, 0);
+            if (*count == cap)
+                *values = realloc(*values, (cap *= 2) * sizeof(long));
+            (*values)[(*count)++] = v;
+            c = end - 1;
+        }
+    }
+
+    return c;
+}
+
+static void font_name_from_gfx(char *dst, size_t len, const char *s)
+{
+    const char *decl = strstr(s, "GFXfont");
+    if (decl == NULL)
+        return;
+
+    decl += strlen("GFXfont");
+    while (isspace((unsigned char)*decl))
+        ++decl;
+
+    size_t i = 0;
+    for (; (isalnum((unsigned char)decl[i]) || decl[i] == '_') && i + 7 < len; ++i)
+        dst[i] = decl[i];
+    strcpy(dst + i, "Packed");
+}
+
+static void load_gfx(font_t *font, char *text)
+{
+    long *bitmap, *glyphs, *info;
+    size_t bitmap_count, glyph_count, info_count;
+
+    strip_comments(text);
+    if (!font->name[0])
+        font_name_from_gfx(font->name, sizeof(font->name), text);
+
+    char *rest = parse_initializer(text, "uint8_t", &bitmap, &bitmap_count);
+    if (rest == NULL || (rest = parse_initializer(rest, "GFXglyph", &glyphs, &glyph_count)) == NULL)
+        die("no GFX bitmap and glyph arrays found", NULL);
+    if (parse_initializer(rest, "GFXfont", &info, &info_count) == NULL || info_count < 3)
+        die("no GFXfont definition found", NULL);
+
+    font->first = (uint16_t)info[info_count - 3];
+    font->last = (uint16_t)info[info_count - 2];
+    font->yAdvance = (uint8_t)info[info_count - 1];
+
+    const size_t n = font->last - font->first + 1;
+    if (font->last < font->first || glyph_count < n * 6)
+        die("glyph array does not cover first..last", NULL);
+
+    font->glyphs = calloc(n, sizeof(glyph_t));
+    for (size_t i = 0; i < n; ++i)
+    {
+        const long *g = glyphs + i * 6;
+        glyph_t *dst = &font->glyphs[i];
+        dst->width = (uint8_t)g[1];
+        dst->height = (uint8_t)g[2];
+        dst->xAdvance = (uint8_t)g[3];
+        dst->xOffset = (int8_t)g[4];
+        dst->yOffset = (int8_t)g[5];
+        dst->rows = calloc((size_t)dst->width * dst->height + 1, 1);
+
+        // GFX bitmaps are row-major, MSB first, without padding between rows
+        for (size_t bit = 0; bit < (size_t)dst->width * dst->height; ++bit)
+        {
+            const size_t byte = g[0] + bit / 8;
+            if (byte >= bitmap_count)
+                die("glyph bitmap exceeds bitmap array", NULL);
+            dst->rows[bit] = (bitmap[byte] >> (7 - bit % 8)) & 1;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------- BDF ---- */
+
+static void load_bdf(font_t *font, char *text, uint16_t first, uint16_t last)
+{
+    font->first = first;
+    font->last = last;
+    font->glyphs = calloc(last - first + 1, sizeof(glyph_t));
+
+    int ascent = -1, descent = -1, bbox_height = 0;
+    long encoding = -1;
+    int dwidth = 0, w = 0, h = 0, xoff = 0, yoff = 0;
+
+    for (char *line = strtok(text, "\n"); line; line = strtok(NULL, "\n"))
+    {
+        if (sscanf(line, "FONTBOUNDINGBOX %*d %d", &bbox_height) == 1)
+            continue;
+        if (sscanf(line, "FONT_ASCENT %d", &ascent) == 1 || sscanf(line, "FONT_DESCENT %d", &descent) == 1)
+            continue;
+        if (sscanf(line, "ENCODING %ld", &encoding) == 1 || sscanf(line, "DWIDTH %d", &dwidth) == 1)
+            continue;
+        if (sscanf(line, "BBX %d %d %d %d", &w, &h, &xoff, &yoff) == 4)
+            continue;
+        if (strncmp(line, "BITMAP", 6) != 0)
+            continue;
+
+        const bool wanted = encoding >= first && encoding <= last;
+        glyph_t *g = wanted ? &font->glyphs[encoding - first] : NULL;
+        if (g)
+        {
+            g->width = (uint8_t)w;
+            g->height = (uint8_t)h;
+            g->xAdvance = (uint8_t)dwidth;
+            g->xOffset = (int8_t)xoff;
+            g->yOffset = (int8_t)-(yoff + h); // BDF offsets are relative to the bottom left corner
+            g->rows = calloc((size_t)w * h + 1, 1);
+        }
+
+        // BDF rows are hex strings, MSB first, padded to whole bytes
+        for (int row = 0; row < h; ++row)
+        {
+            char *hex = strtok(NULL, "\n");
+            if (hex == NULL)
+                die("truncated BITMAP", NULL);
+            for (int col = 0; g && col < w; ++col)
+            {
+                const char digit[2] = {hex[col / 4], '\0'};
+                g->rows[row * w + col] = (strtol(digit, NULL, 16) >> (3 - col % 4)) & 1;
+            }
+        }
+        encoding = -1;
+    }
+
+    font->yAdvance = (uint8_t)(ascent >= 0 && descent >= 0 ? ascent + descent : bbox_height);
+}
+
+/* ------------------------------------------------------------- output ---- */
+
+static void print_char_comment(uint16_t code)
+{
+    if (code >= 0x20 && code < 0x7F && code != '\\')
+        printf(" // 0x%02X '%c'\n", code, code);
+    else
+        printf(" // 0x%02X\n", code);
+}
+
+static void write_packed(const font_t *font, const char *source)
+{
+    const size_t n = font->last - font->first + 1;
+
+    printf("/**\n * %s, generated from %s by tools/fontconv.c\n */\n\n", font->name, source);
+    printf("#pragma once\n#include \"ssd1309_font.h\"\n\n");
+
+    // Columns are stored top to bottom, LSB first, one byte per 8 rows
+    printf("const uint8_t %sData[] = {", font->name);
+    size_t offset = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const glyph_t *g = &font->glyphs[i];
+        const int bytes = (g->height + 7) / 8;
+        for (int col = 0; col < g->width; ++col)
+        {
+            for (int b = 0; b < bytes; ++b)
+            {
+                uint8_t v = 0;
+                for (int bit = 0; bit < 8 && b * 8 + bit < g->height; ++bit)
+                    v |= g->rows[(b * 8 + bit) * g->width + col] << bit;
+                printf("%s0x%02X,", offset % 12 ? " " : "\n    ", v);
+                ++offset;
+            }
+        }
+    }
+    if (offset == 0)
+        printf("0x00");
+    printf("\n};\n\n");
+
+    if (offset > UINT16_MAX)
+        die("font data exceeds 64 KiB", NULL);
+
+    printf("const ssd1309_glyph_t %sGlyphs[] = {\n", font->name);
+    offset = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const glyph_t *g = &font->glyphs[i];
+        printf("    {%zu, %u, %u, %u, %d, %d},", offset, g->width, g->height, g->xAdvance, g->xOffset, g->yOffset);
+        print_char_comment(font->first + i);
+        offset += (size_t)g->width * ((g->height + 7) / 8);
+    }
+    printf("};\n\n");
+
+    printf("const ssd1309_font_t %s = {%sData, %sGlyphs, 0x%02X, 0x%02X, %u};\n",
+           font->name, font->name, font->name, font->first, font->last, font->yAdvance);
+}
+
+int main(int argc, char **argv)
+{
+    font_t font = {0};
+    long first = 0x20, last = 0x7E;
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+    {
+        if (strcmp(argv[i], "-f") == 0)
+            first = strtol(argv[i + 1], NULL, 0);
+        else if (strcmp(argv[i], "-l") == 0)
+            last = strtol(argv[i + 1], NULL, 0);
+        else if (strcmp(argv[i], "-n") == 0)
+            snprintf(font.name, sizeof(font.name), "%s", argv[i + 1]);
+        else
+            die("unknown option", argv[i]);
+    }
+
+    if (i + 1 != argc)
+    {
+        fprintf(stderr, "usage: %s [-f first] [-l last] [-n name] <font.h|font.bdf>\n", argv[0]);
+        return 1;
+    }
+    if (first < 0 || last >= MAX_GLYPHS || first > last)
+        die("invalid character range", NULL);
+
+    const char *path = argv[i];
+    char *text = read_file(path);
+    const char *ext = strrchr(path, '.');
+
+    if (ext && strcmp(ext, ".bdf") == 0)
+    {
+        if (!font.name[0])
+            identifier_from_path(font.name, sizeof(font.name), path);
+        load_bdf(&font, text, (uint16_t)first, (uint16_t)last);
+    }
+    else
+    {
+        load_gfx(&font, text);
+    }
+
+    if (!font.name[0])
+        die("cannot derive a font name, use -n", NULL);
+
+    const char *base = strrchr(path, '/');
+    write_packed(&font, base ? base + 1 : path);
+
+    return 0;
+}